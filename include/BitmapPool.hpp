@@ -0,0 +1,217 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include "StoragePool.hpp"
+#include "mempool_common.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MP_BITMAP_AVX2 1
+#endif
+
+#ifndef BITMAP_POOL_H
+#define BITMAP_POOL_H
+
+namespace mp
+{
+/// Fixed-block pool that keeps track of reserved slots in an occupancy bitmap.
+/**
+ * Every slot has exactly BLK_SIZE bytes, so a request is served by any free slot
+ * as long as it fits in one. The bitmap lives apart from the slots, which means
+ * the allocator never writes into (or reads from) memory handed to the client.
+ */
+template <size_t BLK_SIZE = 64>
+class BitmapPool : public StoragePool
+{
+public:
+  struct Block
+  {
+    char m_raw[BLK_SIZE]; // Client's raw area
+  };
+
+  typedef uint64_t Word; //!< One bitmap word, 1 bit per slot (1 = reserved).
+
+  static constexpr size_t BLK_SZ = sizeof(mp::BitmapPool<BLK_SIZE>::Block); //!< The block size in bytes.
+  static constexpr size_t TAG_SZ = sizeof(mp::Tag);                         //!< The Tag size in bytes (each reserved area has a tag).
+  static constexpr size_t WORD_BITS = 8 * sizeof(Word);                     //!< Slots tracked by a single word.
+  static constexpr size_t STRIDE = 4;                                       //!< Words compared by a single AVX2 instruction.
+
+  static_assert(BLK_SIZE >= sizeof(mp::Tag), "a block must be able to hold at least the Tag");
+
+private:
+  /// Returns the index of the first word in [from, to) with a free slot, or `to`.
+  typedef size_t (*Finder)(const Word *, size_t, size_t);
+
+  size_t m_n_blocks; //!< Number of slots in the pool.
+  size_t m_n_words;  //!< Number of bitmap words (a multiple of STRIDE).
+  size_t m_hint;     //!< Word where the last successful search stopped.
+  Block *m_pool;     //!< The slots themselves.
+  Word *m_bitmap;    //!< Occupancy bitmap, kept out of the slots.
+  Finder m_find;     //!< Free word search picked for this CPU.
+
+public:
+  /// Constructor of BitmapPool, reserves enough slots to hold `bytes` bytes.
+  explicit BitmapPool(size_t bytes) : m_n_blocks{(bytes + BLK_SZ - 1) / BLK_SZ},
+                                      m_n_words{((m_n_blocks + WORD_BITS - 1) / WORD_BITS + STRIDE - 1) / STRIDE * STRIDE},
+                                      m_hint{0u},
+                                      m_pool{new Block[m_n_blocks]},
+                                      m_bitmap{new Word[m_n_words]},
+                                      m_find{SelectFinder()}
+  {
+    this->Reset();
+  }
+
+  /// Destructs the BitmapPool.
+  ~BitmapPool()
+  {
+    delete[] m_bitmap;
+    delete[] m_pool;
+  }
+
+  BitmapPool(const BitmapPool &) = delete;
+  BitmapPool &operator=(const BitmapPool &) = delete;
+
+  void *Allocate(size_t bytes)
+  {
+    void *ptr = this->Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+
+    return ptr;
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
+  {
+    if (bytes > BLK_SZ)
+      return nullptr;
+
+    // Search from the hint to the end, then wrap around.
+    size_t word = m_find(m_bitmap, m_hint, m_n_words);
+    if (word == m_n_words)
+    {
+      word = m_find(m_bitmap, 0u, m_hint);
+      if (word == m_hint)
+        return nullptr;
+    }
+
+    size_t bit = __builtin_ctzll(~m_bitmap[word]);
+    m_bitmap[word] |= Word(1) << bit;
+    m_hint = word;
+
+    return reinterpret_cast<void *>(m_pool + (word * WORD_BITS + bit));
+  }
+
+  void Free(void *ptr)
+  {
+    size_t slot = (reinterpret_cast<char *>(ptr) - reinterpret_cast<char *>(m_pool)) / BLK_SZ;
+
+    m_bitmap[slot / WORD_BITS] &= ~(Word(1) << (slot % WORD_BITS));
+  }
+
+  /// Releases every reserved slot at once.
+  void FreeAll()
+  {
+    this->Reset();
+  }
+
+  /// Number of slots in the pool.
+  size_t Capacity() const
+  {
+    return m_n_blocks;
+  }
+
+  /// Number of reserved slots, counted straight from the bitmap.
+  size_t Reserved() const
+  {
+    size_t count = 0u;
+    for (size_t i = 0u; i < m_n_words; ++i)
+      count += __builtin_popcountll(m_bitmap[i]);
+
+    // Slots past the end are permanently marked as reserved.
+    return count - (m_n_words * WORD_BITS - m_n_blocks);
+  }
+
+  /// Calls `fn(ptr)` for each reserved slot, in address order.
+  template <typename Fn>
+  void ForEachReserved(Fn fn) const
+  {
+    for (size_t i = 0u; i < m_n_words; ++i)
+    {
+      Word bits = m_bitmap[i];
+      while (bits != 0u)
+      {
+        size_t slot = i * WORD_BITS + __builtin_ctzll(bits);
+        if (slot >= m_n_blocks)
+          return;
+        fn(reinterpret_cast<void *>(m_pool + slot));
+        bits &= bits - 1u;
+      }
+    }
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream, const BitmapPool &obj)
+  {
+    stream << " BitmapPool { blocks: " << obj.m_n_blocks << ", reserved: " << obj.Reserved() << " } " << std::endl;
+
+    return stream;
+  }
+
+private:
+  /// Clears the bitmap, keeping the padding bits past the last slot set.
+  void Reset()
+  {
+    std::memset(m_bitmap, 0, m_n_words * sizeof(Word));
+
+    for (size_t slot = m_n_blocks; slot < m_n_words * WORD_BITS; ++slot)
+      m_bitmap[slot / WORD_BITS] |= Word(1) << (slot % WORD_BITS);
+
+    m_hint = 0u;
+  }
+
+  static size_t FindScalar(const Word *bits, size_t from, size_t to)
+  {
+    while (from < to and bits[from] == ~Word(0))
+      ++from;
+
+    return from;
+  }
+
+#ifdef MP_BITMAP_AVX2
+  /// Skips full words eight at a time (512 slots) with two AVX2 loads.
+  __attribute__((target("avx2"))) static size_t FindAVX2(const Word *bits, size_t from, size_t to)
+  {
+    while (from < to and from % STRIDE != 0u)
+    {
+      if (bits[from] != ~Word(0))
+        return from;
+      ++from;
+    }
+
+    const __m256i full = _mm256_set1_epi64x(-1);
+    for (; from + 2u * STRIDE <= to; from += 2u * STRIDE)
+    {
+      __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bits + from));
+      __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bits + from + STRIDE));
+      if (not _mm256_testc_si256(_mm256_and_si256(lo, hi), full))
+        break;
+    }
+
+    return FindScalar(bits, from, to);
+  }
+#endif
+
+  static Finder SelectFinder()
+  {
+#ifdef MP_BITMAP_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return &FindAVX2;
+#endif
+    return &FindScalar;
+  }
+};
+} // namespace mp
+
+#endif
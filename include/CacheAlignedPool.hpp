@@ -0,0 +1,115 @@
+#include <stddef.h>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include "StoragePool.hpp"
+#include "SLPool.hpp"
+#include "mempool_common.h"
+
+#ifndef CACHE_ALIGNED_POOL_H
+#define CACHE_ALIGNED_POOL_H
+
+namespace mp
+{
+/// SLPool laid out in cache lines, so that areas handed to different threads never share a line.
+/**
+ * The blocks are LINE bytes long and the storage is aligned to LINE, hence every
+ * area spans whole lines and the Header and Tag of an area never sit next to the
+ * data of its neighbour. With the DATA_ON_LINE layout each area is padded so that
+ * the client's data also begins on a line: the Header and the Tag are moved out of
+ * that line into one of their own (at the cost of one more line per area).
+ *
+ * With DATA_ON_LINE, it is `ptr + TAG_SZ` that is aligned for a `ptr` returned by
+ * Allocate(), which is where `new (pool)` places the object.
+ */
+template <size_t LINE = 64>
+class CacheAlignedPool : public StoragePool
+{
+public:
+  enum Layout
+  {
+    WHOLE_LINES, //!< Areas are made of whole lines; metadata shares the first line with the data.
+    DATA_ON_LINE //!< As above, and the data begins on a line: metadata has a line of its own.
+  };
+
+  static constexpr size_t LINE_SZ = LINE;                      //!< The cache line size in bytes.
+  static constexpr size_t TAG_SZ = sizeof(mp::Tag);            //!< The Tag size in bytes (each reserved area has a tag).
+  static constexpr size_t HEADER_SZ = SLPool<LINE>::HEADER_SZ; //!< The header size in bytes.
+  static constexpr size_t PAD = LINE - HEADER_SZ - TAG_SZ;     //!< Padding between the Header and the Tag with DATA_ON_LINE.
+
+  static_assert((LINE & (LINE - 1u)) == 0u, "the line size must be a power of two");
+  static_assert(SLPool<LINE>::BLK_SZ == LINE, "a block must be exactly one line");
+  static_assert(LINE >= HEADER_SZ + TAG_SZ, "a line must hold the Header and the Tag");
+
+private:
+  size_t m_pad;        //!< Bytes skipped at the start of each area.
+  size_t m_bytes;      //!< Size of the storage.
+  void *m_storage;     //!< Line-aligned storage of the pool.
+  SLPool<LINE> m_pool;  //!< The pool itself, laid out over m_storage.
+
+public:
+  /// Constructor of CacheAlignedPool, reserves room for `bytes` bytes laid out as `layout`.
+  explicit CacheAlignedPool(size_t bytes, Layout layout = WHOLE_LINES) : m_pad{layout == DATA_ON_LINE ? PAD : 0u},
+                                                                          m_bytes{((bytes + m_pad + HEADER_SZ + LINE - 1u) / LINE + 1u) * LINE},
+                                                                          m_storage{Lines(m_bytes)},
+                                                                          m_pool{m_storage, m_bytes}
+  { /* Empty */
+  }
+
+  /// Destructs the CacheAlignedPool.
+  ~CacheAlignedPool()
+  {
+    std::free(m_storage);
+  }
+
+  CacheAlignedPool(const CacheAlignedPool &) = delete;
+  CacheAlignedPool &operator=(const CacheAlignedPool &) = delete;
+
+  void *Allocate(size_t bytes)
+  {
+    void *ptr = this->Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+
+    return ptr;
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
+  {
+    char *area = reinterpret_cast<char *>(m_pool.Allocate(bytes + m_pad, std::nothrow));
+
+    return area == nullptr ? nullptr : area + m_pad;
+  }
+
+  void Free(void *ptr)
+  {
+    m_pool.Free(reinterpret_cast<char *>(ptr) - m_pad);
+  }
+
+  /// Layout the pool was built with.
+  Layout GetLayout() const
+  {
+    return m_pad == 0u ? WHOLE_LINES : DATA_ON_LINE;
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream, const CacheAlignedPool &obj)
+  {
+    stream << " CacheAlignedPool { line: " << LINE << ", layout: " << (obj.m_pad == 0u ? "whole lines" : "data on line") << " } " << std::endl;
+
+    return stream;
+  }
+
+private:
+  /// Reserves `bytes` bytes aligned to a line.
+  static void *Lines(size_t bytes)
+  {
+    void *storage;
+    if (posix_memalign(&storage, LINE, bytes) != 0)
+      throw std::bad_alloc();
+
+    return storage;
+  }
+};
+} // namespace mp
+
+#endif
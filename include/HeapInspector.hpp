@@ -0,0 +1,306 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifndef HEAP_INSPECTOR_H
+#define HEAP_INSPECTOR_H
+
+namespace mp
+{
+/// Totals of a heap walk.
+struct HeapSummary
+{
+  size_t m_areas = 0u;        //!< Areas, reserved and free.
+  size_t m_free_areas = 0u;   //!< Free areas.
+  size_t m_used_bytes = 0u;   //!< Bytes in reserved areas (headers included).
+  size_t m_free_bytes = 0u;   //!< Bytes in free areas.
+  size_t m_largest_free = 0u; //!< Bytes in the largest free area.
+
+  void Add(size_t bytes, bool free)
+  {
+    ++m_areas;
+    if (free)
+    {
+      ++m_free_areas;
+      m_free_bytes += bytes;
+      m_largest_free = bytes > m_largest_free ? bytes : m_largest_free;
+    }
+    else
+      m_used_bytes += bytes;
+  }
+
+  /// Share of the free bytes that lie outside the largest free area (0: none, 1: all of it).
+  double Fragmentation() const
+  {
+    return m_free_bytes == 0u ? 0.0 : 1.0 - double(m_largest_free) / m_free_bytes;
+  }
+};
+
+/// Heap map read back from a binary dump; it can be walked like the pool it came from.
+struct HeapMap
+{
+  struct Area
+  {
+    uint64_t m_offset; //!< Bytes from the start of the pool.
+    uint64_t m_bytes;
+    bool m_free;
+  };
+
+  uint32_t m_block = 0u;    //!< Block size of the pool.
+  uint64_t m_base = 0u;     //!< Address of the pool in the dumped process.
+  std::vector<Area> m_areas;
+
+  /// Calls `fn(area, bytes, free)` for every area, in address order (`area` is the address in the dumped process).
+  template <typename Fn>
+  void Walk(Fn fn) const
+  {
+    for (const Area &area : m_areas)
+      fn(reinterpret_cast<const void *>(uintptr_t(m_base + area.m_offset)), size_t(area.m_bytes), area.m_free);
+  }
+};
+
+/// Walks pools (anything with a Walk(fn) like SLPool's) and exports their heap map.
+/**
+ * The binary map is made to be cheap enough to write from a live process: it is
+ * produced straight from the walk through a small stack buffer, with write(2) and
+ * no allocation. Its layout is
+ *
+ *     "GRHM" | version (u32) | block size (u32) | 0 (u32) | base (u64) | areas (u64)
+ *
+ * followed by one LEB128 number per area, in address order: its length in blocks,
+ * shifted left by one, with the lowest bit set for a free area. Offsets are implied
+ * since areas tile the pool. The JSON map holds the same `[offset, bytes, free]`
+ * triples, in bytes, for other tools.
+ *
+ * The pool is walked once, so the areas are counted as they are written and the
+ * count is patched into the header afterwards. That takes a seekable file: on a
+ * pipe or a socket the count is left as UNCOUNTED, and the areas run to the end of
+ * the stream.
+ */
+class HeapInspector
+{
+public:
+  static constexpr uint32_t VERSION = 1u;
+  static constexpr uint64_t UNCOUNTED = ~uint64_t(0); //!< Area count of a map that runs to the end of the stream.
+
+  /// Totals of `heap`.
+  template <typename Heap>
+  static HeapSummary Summarize(const Heap &heap)
+  {
+    HeapSummary summary;
+    heap.Walk([&summary](const void *, size_t bytes, bool free) { summary.Add(bytes, free); });
+
+    return summary;
+  }
+
+  /// Writes the binary map of `heap` (whose blocks have `block` bytes) to `fd`; returns false on a write error.
+  template <typename Heap>
+  static bool WriteBinary(const Heap &heap, size_t block, int fd)
+  {
+    // Where the header lands, if the count can be patched in there afterwards (pwrite() ignores it under O_APPEND).
+    const int flags = fcntl(fd, F_GETFL);
+    const off_t start = flags < 0 or (flags & O_APPEND) != 0 ? off_t(-1) : lseek(fd, 0, SEEK_CUR);
+
+    uint64_t base = 0u, n_areas = start < 0 ? UNCOUNTED : 0u;
+    char header[32] = {'G', 'R', 'H', 'M'};
+    uint32_t fields[] = {VERSION, uint32_t(block), 0u};
+    std::memcpy(header + 4, fields, sizeof(fields));
+    std::memcpy(header + 16, &base, sizeof(base));
+    std::memcpy(header + 24, &n_areas, sizeof(n_areas));
+
+    Writer writer(fd);
+    writer.Put(header, sizeof(header));
+    n_areas = 0u;
+    heap.Walk([&](const void *area, size_t bytes, bool free) {
+      if (n_areas++ == 0u)
+      {
+        // The header is still in the buffer.
+        base = reinterpret_cast<uintptr_t>(area);
+        writer.Patch(16u, &base, sizeof(base));
+      }
+
+      uint64_t value = (uint64_t(bytes / block) << 1) | free;
+      char varint[10];
+      size_t n = 0u;
+      do
+      {
+        varint[n++] = char((value & 0x7fu) | (value > 0x7fu ? 0x80u : 0u));
+        value >>= 7;
+      } while (value != 0u);
+      writer.Put(varint, n);
+    });
+
+    if (not writer.Flush())
+      return false;
+
+    return start < 0 or pwrite(fd, &n_areas, sizeof(n_areas), start + 24) == ssize_t(sizeof(n_areas));
+  }
+
+  /// Writes the map of `heap` as JSON: {"block": B, "base": A, "areas": [[offset, bytes, free], ...]}.
+  template <typename Heap>
+  static void WriteJson(const Heap &heap, size_t block, std::ostream &stream)
+  {
+    uintptr_t base = 0u;
+    bool first = true;
+
+    stream << "{\"block\":" << block << ",\"areas\":[";
+    heap.Walk([&](const void *area, size_t bytes, bool free) {
+      if (first)
+        base = reinterpret_cast<uintptr_t>(area);
+      stream << (first ? "" : ",") << '[' << reinterpret_cast<uintptr_t>(area) - base << ',' << bytes << ',' << int(free) << ']';
+      first = false;
+    });
+    stream << "],\"base\":" << base << "}\n";
+  }
+
+  /// Reads a binary map; returns false if the stream does not hold one.
+  static bool ReadBinary(std::istream &stream, HeapMap &map)
+  {
+    char header[32];
+    if (not stream.read(header, sizeof(header)) or std::memcmp(header, "GRHM", 4) != 0)
+      return false;
+
+    uint32_t fields[3];
+    uint64_t n_areas;
+    std::memcpy(fields, header + 4, sizeof(fields));
+    std::memcpy(&map.m_base, header + 16, sizeof(map.m_base));
+    std::memcpy(&n_areas, header + 24, sizeof(n_areas));
+    if (fields[0] != VERSION or fields[1] == 0u)
+      return false;
+    map.m_block = fields[1];
+
+    map.m_areas.clear();
+    uint64_t offset = 0u;
+    for (uint64_t i = 0u; i < n_areas; ++i)
+    {
+      if (n_areas == UNCOUNTED and stream.peek() == EOF)
+        break;
+
+      uint64_t value = 0u;
+      for (unsigned shift = 0u;; shift += 7u)
+      {
+        int byte = stream.get();
+        if (byte == EOF or shift > 63u)
+          return false;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+          break;
+      }
+
+      HeapMap::Area area = {offset, (value >> 1) * map.m_block, (value & 1u) != 0u};
+      map.m_areas.push_back(area);
+      offset += area.m_bytes;
+    }
+
+    return true;
+  }
+
+  /// Writes the binary map of `heap` to `path` every time the process receives `signo`.
+  /**
+   * The handler opens the file, walks the pool and writes the map without
+   * allocating. The pool should be quiescent (e.g. the signal is sent while the
+   * program waits), otherwise the map may be torn.
+   */
+  template <typename Heap>
+  static bool InstallSignalHandler(const Heap &heap, size_t block, int signo, const char *path)
+  {
+    Target &target = SignalTarget();
+    if (std::strlen(path) >= sizeof(target.m_path))
+      return false;
+
+    std::strcpy(target.m_path, path);
+    target.m_heap = &heap;
+    target.m_block = block;
+    target.m_write = [](const void *heap, size_t block, int fd) { return WriteBinary(*static_cast<const Heap *>(heap), block, fd); };
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = OnSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    return sigaction(signo, &action, nullptr) == 0;
+  }
+
+private:
+  /// Buffers writes to a file descriptor.
+  class Writer
+  {
+  private:
+    int m_fd;
+    size_t m_used;
+    bool m_ok;
+    char m_buffer[4096];
+
+  public:
+    explicit Writer(int fd) : m_fd(fd), m_used(0u), m_ok(true)
+    { /* Empty */
+    }
+
+    void Put(const char *bytes, size_t n)
+    {
+      if (m_used + n > sizeof(m_buffer))
+        this->Flush();
+      std::memcpy(m_buffer + m_used, bytes, n);
+      m_used += n;
+    }
+
+    /// Overwrites bytes already Put() at `offset` in the buffer; only until it is first flushed.
+    void Patch(size_t offset, const void *bytes, size_t n)
+    {
+      std::memcpy(m_buffer + offset, bytes, n);
+    }
+
+    bool Flush()
+    {
+      for (size_t done = 0u; done < m_used and m_ok;)
+      {
+        ssize_t n = write(m_fd, m_buffer + done, m_used - done);
+        if (n > 0)
+          done += n;
+        else if (n == 0 or errno != EINTR) // No progress is as fatal as an error.
+          m_ok = false;
+      }
+      m_used = 0u;
+
+      return m_ok;
+    }
+  };
+
+  struct Target
+  {
+    const void *m_heap;
+    size_t m_block;
+    bool (*m_write)(const void *, size_t, int);
+    char m_path[256];
+  };
+
+  static Target &SignalTarget()
+  {
+    static Target target = {nullptr, 0u, nullptr, {0}};
+    return target;
+  }
+
+  static void OnSignal(int)
+  {
+    int saved = errno;
+    Target &target = SignalTarget();
+    int fd = open(target.m_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0)
+    {
+      target.m_write(target.m_heap, target.m_block, fd);
+      close(fd);
+    }
+    errno = saved;
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,468 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef HEAP_PROFILER_H
+#define HEAP_PROFILER_H
+
+namespace mp
+{
+/// Sampling heap profiler used by the operator new/delete of mempool_common.h (see MP_HEAP_PROFILER).
+/**
+ * Each thread samples, on average, one allocation every SamplingRate() bytes: the
+ * distance to the next sample is drawn from an exponential distribution, so every
+ * byte has the same chance of being sampled (Poisson sampling). A sampled area gets
+ * a stack trace and stays in a table until it is deleted; its weight is the number
+ * of bytes it stands for, bytes / (1 - exp(-bytes / rate)).
+ *
+ * The live samples are written as folded stacks ("root;...;leaf weight" lines), ready
+ * for flamegraph.pl, speedscope or `pprof -raw`-style converters. Names are left
+ * mangled; pipe the profile through c++filt to read them. Binaries must be linked
+ * with -rdynamic for their own functions to get names instead of offsets.
+ *
+ * The profiler never allocates through operator new or malloc: the per-thread state
+ * and the first CAPACITY slots are static, and the table doubles into anonymous
+ * mappings as it fills up. Samples are dropped only if such a mapping fails; they
+ * are counted (see Dropped()) and reported in the profile as a "[dropped]" stack.
+ */
+class HeapProfiler
+{
+public:
+  static constexpr size_t MAX_DEPTH = 32;            //!< Frames kept per sample.
+  static constexpr size_t CAPACITY = 4096;           //!< Slots the table starts with (a power of two).
+  static constexpr size_t DEFAULT_RATE = 512 * 1024; //!< Mean bytes between two samples.
+
+  struct Sample
+  {
+    void *m_ptr;                 //!< Sampled client area (nullptr for an empty slot).
+    size_t m_bytes;              //!< Requested size.
+    size_t m_weight;             //!< Bytes this sample stands for.
+    int m_depth;                 //!< Number of valid frames.
+    void *m_frames[MAX_DEPTH];   //!< Return addresses, innermost first.
+  };
+
+  /// Sets the mean distance between samples, in bytes; 0 stops sampling.
+  static void SetSamplingRate(size_t bytes)
+  {
+    Rate().store(bytes, std::memory_order_relaxed);
+  }
+
+  static size_t SamplingRate()
+  {
+    return Rate().load(std::memory_order_relaxed);
+  }
+
+  /// Fast path: whether an allocation of `bytes` must be sampled.
+  static bool ShouldSample(size_t bytes)
+  {
+    ThreadState &state = Thread();
+    state.m_left -= int64_t(bytes);
+    if (state.m_left > 0)
+      return false;
+
+    return Resample(state);
+  }
+
+  /// Records a sampled area; returns false when the table is full and can't grow (the sample is dropped).
+  __attribute__((noinline)) static bool Record(void *ptr, size_t bytes)
+  {
+    ThreadState &state = Thread();
+    state.m_busy = true;
+
+    void *frames[MAX_DEPTH + SKIP];
+    int depth = backtrace(frames, MAX_DEPTH + SKIP) - SKIP;
+    size_t rate = SamplingRate();
+    double weight = rate == 0u ? bytes : bytes / -std::expm1(-double(bytes) / rate);
+
+    Lock();
+    Table &table = Samples();
+    bool stored = table.m_count < table.m_capacity * 3 / 4 or Grow(table);
+    if (stored)
+    {
+      size_t slot = Slot(ptr, table.m_capacity);
+      while (table.m_samples[slot].m_ptr != nullptr)
+        slot = (slot + 1u) % table.m_capacity;
+
+      Sample &sample = table.m_samples[slot];
+      sample.m_ptr = ptr;
+      sample.m_bytes = bytes;
+      sample.m_weight = size_t(weight);
+      sample.m_depth = depth < 0 ? 0 : depth;
+      std::memcpy(sample.m_frames, frames + SKIP, sample.m_depth * sizeof(void *));
+      ++table.m_count;
+      table.m_live_bytes += sample.m_weight;
+    }
+    else
+    {
+      ++table.m_dropped;
+      table.m_dropped_bytes += size_t(weight);
+    }
+    Unlock();
+
+    state.m_busy = false;
+    return stored;
+  }
+
+  /// Forgets a sampled area that is being deleted.
+  static void Forget(void *ptr)
+  {
+    Lock();
+    Table &table = Samples();
+
+    const size_t capacity = table.m_capacity;
+    size_t slot = Slot(ptr, capacity);
+    while (table.m_samples[slot].m_ptr != nullptr and table.m_samples[slot].m_ptr != ptr)
+      slot = (slot + 1u) % capacity;
+
+    if (table.m_samples[slot].m_ptr == ptr)
+    {
+      table.m_live_bytes -= table.m_samples[slot].m_weight;
+      --table.m_count;
+
+      // Backward-shift deletion keeps every probe sequence unbroken.
+      size_t hole = slot;
+      for (size_t next = (hole + 1u) % capacity; table.m_samples[next].m_ptr != nullptr; next = (next + 1u) % capacity)
+      {
+        size_t home = Slot(table.m_samples[next].m_ptr, capacity);
+        if ((next - home) % capacity >= (next - hole) % capacity)
+        {
+          table.m_samples[hole] = table.m_samples[next];
+          hole = next;
+        }
+      }
+      table.m_samples[hole].m_ptr = nullptr;
+    }
+    Unlock();
+  }
+
+  /// Estimated number of live bytes, scaled up from the samples.
+  static size_t LiveBytes()
+  {
+    Lock();
+    size_t bytes = Samples().m_live_bytes;
+    Unlock();
+    return bytes;
+  }
+
+  /// Number of live samples.
+  static size_t LiveSamples()
+  {
+    Lock();
+    size_t count = Samples().m_count;
+    Unlock();
+    return count;
+  }
+
+  /// Number of samples dropped because the table could not grow.
+  static size_t Dropped()
+  {
+    Lock();
+    size_t count = Samples().m_dropped;
+    Unlock();
+    return count;
+  }
+
+  /// Writes the live samples as folded stacks to `fd`, with symbol names when `symbolize` is set.
+  static void Dump(int fd, bool symbolize = true)
+  {
+    Lock();
+    DumpLocked(fd, symbolize);
+    Unlock();
+  }
+
+  /// Writes the live samples to the file at `path`; returns false if it can't be opened.
+  static bool Dump(const char *path)
+  {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+      return false;
+
+    Dump(fd);
+    close(fd);
+    return true;
+  }
+
+  /// Dumps the profile (unsymbolized, since only async-signal-safe calls are made) to `path` on `signo`.
+  static bool InstallSignalHandler(int signo, const char *path)
+  {
+    char *target = SignalPath();
+    if (std::strlen(path) >= PATH_SZ)
+      return false;
+    std::strcpy(target, path);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = &OnSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    return sigaction(signo, &action, nullptr) == 0;
+  }
+
+private:
+  static constexpr int SKIP = 1;        //!< Frames of the profiler itself at the top of each trace.
+  static constexpr size_t PATH_SZ = 256; //!< Longest path accepted by InstallSignalHandler().
+
+  struct ThreadState
+  {
+    int64_t m_left;  //!< Bytes left before the next sample.
+    uint64_t m_seed; //!< xorshift state (0 until the first draw).
+    bool m_busy;     //!< Set while recording, so the profiler never samples itself.
+  };
+
+  struct Table
+  {
+    Sample m_initial[CAPACITY]; //!< Slots used until the first Grow().
+    Sample *m_samples;          //!< Current slots (m_initial or a mapping).
+    size_t m_capacity;          //!< Number of slots at m_samples.
+    size_t m_count;             //!< Live samples.
+    size_t m_live_bytes;        //!< Sum of their weights.
+    size_t m_dropped;           //!< Samples dropped so far.
+    size_t m_dropped_bytes;     //!< Sum of their weights, when they were dropped.
+  };
+
+  /// Small buffered writer that only uses write(2).
+  struct Writer
+  {
+    int m_fd;
+    size_t m_used;
+    char m_buffer[4096];
+
+    void Put(const char *text, size_t length)
+    {
+      if (m_used + length > sizeof(m_buffer))
+        Flush();
+      if (length > sizeof(m_buffer))
+        length = sizeof(m_buffer);
+      std::memcpy(m_buffer + m_used, text, length);
+      m_used += length;
+    }
+
+    void Put(const char *text)
+    {
+      Put(text, std::strlen(text));
+    }
+
+    void Put(uintptr_t value, unsigned base)
+    {
+      char digits[2 + 2 * sizeof(uintptr_t) * 4];
+      char *end = digits + sizeof(digits);
+      char *begin = end;
+      do
+      {
+        *--begin = "0123456789abcdef"[value % base];
+        value /= base;
+      } while (value != 0u);
+      if (base == 16u)
+      {
+        *--begin = 'x';
+        *--begin = '0';
+      }
+      Put(begin, end - begin);
+    }
+
+    void Flush()
+    {
+      for (size_t done = 0u; done < m_used;)
+      {
+        ssize_t n = write(m_fd, m_buffer + done, m_used - done);
+        if (n <= 0)
+          break;
+        done += n;
+      }
+      m_used = 0u;
+    }
+  };
+
+  static std::atomic<size_t> &Rate()
+  {
+    static std::atomic<size_t> rate{DEFAULT_RATE};
+    return rate;
+  }
+
+  static ThreadState &Thread()
+  {
+    static thread_local ThreadState state;
+    return state;
+  }
+
+  /// The table; must be called with the lock held.
+  static Table &Samples()
+  {
+    static Table table; // Zero-initialized: no guard, and the slots stay in .bss.
+    if (table.m_samples == nullptr)
+    {
+      table.m_samples = table.m_initial;
+      table.m_capacity = CAPACITY;
+    }
+    return table;
+  }
+
+  /// Doubles the table into a fresh mapping; false (and nothing changes) if mmap() fails.
+  static bool Grow(Table &table)
+  {
+    const size_t capacity = 2u * table.m_capacity;
+    void *memory = mmap(nullptr, capacity * sizeof(Sample), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+      return false;
+
+    Sample *samples = static_cast<Sample *>(memory); // Zero-filled: every slot is empty.
+    for (size_t i = 0u; i < table.m_capacity; ++i)
+      if (table.m_samples[i].m_ptr != nullptr)
+      {
+        size_t slot = Slot(table.m_samples[i].m_ptr, capacity);
+        while (samples[slot].m_ptr != nullptr)
+          slot = (slot + 1u) % capacity;
+        samples[slot] = table.m_samples[i];
+      }
+
+    if (table.m_samples != table.m_initial)
+      munmap(table.m_samples, table.m_capacity * sizeof(Sample));
+    table.m_samples = samples;
+    table.m_capacity = capacity;
+    return true;
+  }
+
+  static std::atomic_flag &Guard()
+  {
+    static std::atomic_flag guard = ATOMIC_FLAG_INIT;
+    return guard;
+  }
+
+  static char *SignalPath()
+  {
+    static char path[PATH_SZ];
+    return path;
+  }
+
+  static void Lock()
+  {
+    while (Guard().test_and_set(std::memory_order_acquire))
+      ; // Spin: critical sections are a handful of stores.
+  }
+
+  static bool TryLock(unsigned attempts)
+  {
+    while (Guard().test_and_set(std::memory_order_acquire))
+      if (attempts-- == 0u)
+        return false;
+    return true;
+  }
+
+  static void Unlock()
+  {
+    Guard().clear(std::memory_order_release);
+  }
+
+  static size_t Slot(const void *ptr, size_t capacity)
+  {
+    return size_t((uintptr_t(ptr) >> 4) * 0x9E3779B97F4A7C15ull >> 32) % capacity;
+  }
+
+  /// Slow path: draws the next sampling distance; the first draw of a thread never samples.
+  static bool Resample(ThreadState &state)
+  {
+    size_t rate = SamplingRate();
+    bool first = state.m_seed == 0u;
+    if (first)
+      state.m_seed = uintptr_t(&state) ^ 0x2545F4914F6CDD1Dull;
+
+    if (rate == 0u)
+    {
+      state.m_left = DEFAULT_RATE; // Check again later, in case sampling is turned back on.
+      return false;
+    }
+
+    // xorshift64*, then an exponential draw with mean `rate`.
+    state.m_seed ^= state.m_seed >> 12;
+    state.m_seed ^= state.m_seed << 25;
+    state.m_seed ^= state.m_seed >> 27;
+    double u = ((state.m_seed * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+    state.m_left = int64_t(-std::log1p(-u) * rate) + 1;
+
+    return not first and not state.m_busy;
+  }
+
+  static void DumpLocked(int fd, bool symbolize)
+  {
+    Writer out;
+    out.m_fd = fd;
+    out.m_used = 0u;
+
+    const Table &table = Samples();
+    for (size_t i = 0u; i < table.m_capacity; ++i)
+    {
+      const Sample &sample = table.m_samples[i];
+      if (sample.m_ptr == nullptr)
+        continue;
+
+      for (int frame = sample.m_depth - 1; frame >= 0; --frame)
+      {
+        PutFrame(out, sample.m_frames[frame], symbolize);
+        out.Put(frame == 0 ? " " : ";");
+      }
+      out.Put(sample.m_weight, 10u);
+      out.Put("\n");
+    }
+
+    // Dropped samples are not in the profile: show how much they stood for.
+    if (table.m_dropped > 0u)
+    {
+      out.Put("[dropped] ");
+      out.Put(table.m_dropped_bytes, 10u);
+      out.Put("\n");
+    }
+    out.Flush();
+  }
+
+  static void PutFrame(Writer &out, void *address, bool symbolize)
+  {
+    Dl_info info;
+    if (symbolize and dladdr(address, &info) != 0)
+    {
+      if (info.dli_sname != nullptr)
+      {
+        out.Put(info.dli_sname);
+        return;
+      }
+      if (info.dli_fname != nullptr)
+      {
+        const char *name = std::strrchr(info.dli_fname, '/');
+        out.Put(name == nullptr ? info.dli_fname : name + 1);
+        out.Put("+");
+        out.Put(uintptr_t(address) - uintptr_t(info.dli_fbase), 16u);
+        return;
+      }
+    }
+    out.Put(uintptr_t(address), 16u);
+  }
+
+  static void OnSignal(int)
+  {
+    int saved = errno;
+    int fd = open(SignalPath(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0)
+    {
+      // The interrupted code may hold the lock on this very thread: give up rather than deadlock.
+      if (TryLock(1u << 20))
+      {
+        DumpLocked(fd, false);
+        Unlock();
+      }
+      close(fd);
+    }
+    errno = saved;
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,314 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <ostream>
+#include "StoragePool.hpp"
+#include "mempool_common.h"
+
+#ifndef INDEXED_POOL_H
+#define INDEXED_POOL_H
+
+namespace mp
+{
+/// Variable-size pool whose free areas are indexed by size (best fit) and by address (neighbours).
+/**
+ * Areas have the same layout as in SLPool: a Header with the length in blocks,
+ * followed by the client's bytes. Each free area also holds the links of two
+ * treaps: one ordered by address, used by Free() to find the neighbours to
+ * coalesce with, and one ordered by (length, address), used by Allocate() to
+ * find the smallest area that fits. Both are O(log n) in the number of free
+ * areas, however fragmented the pool gets, and need no memory besides the free
+ * areas themselves. In exchange, an area is never shorter than MIN_BLOCKS blocks.
+ */
+template <size_t BLK_SIZE = 16>
+class IndexedPool : public StoragePool
+{
+public:
+  struct Header
+  {
+    size_t m_length;
+    Header() : m_length(0u){/* Empty */};
+  };
+
+  struct Block : public Header
+  {
+    char m_raw[BLK_SIZE - sizeof(Header)]; // Client's raw area
+  };
+
+private:
+  enum Tree
+  {
+    BY_ADDRESS = 0,
+    BY_SIZE = 1
+  };
+
+  /// What a free area holds: its header and the links of both trees.
+  struct Node : public Header
+  {
+    Node *m_links[2][2]; //!< [tree][left, right]
+  };
+
+  size_t m_n_blocks;  //!< Number of blocks in the pool.
+  Block *m_pool;      //!< The blocks themselves.
+  Node *m_roots[2];   //!< Roots of the address tree and of the size tree.
+  size_t m_n_free;    //!< Number of free areas.
+
+public:
+  static constexpr size_t BLK_SZ = sizeof(mp::IndexedPool<BLK_SIZE>::Block);      //!< The block size in bytes.
+  static constexpr size_t TAG_SZ = sizeof(mp::Tag);                               //!< The Tag size in bytes (each reserved area has a tag).
+  static constexpr size_t HEADER_SZ = sizeof(mp::IndexedPool<BLK_SIZE>::Header); //!< The header size in bytes.
+  static constexpr size_t MIN_BLOCKS = (sizeof(Node) + BLK_SZ - 1u) / BLK_SZ;     //!< Length of the shortest area.
+
+  static_assert(BLK_SIZE > sizeof(Header), "a block must hold more than the Header");
+
+  /// Constructor of IndexedPool, set the number of blocks and the memory pool.
+  explicit IndexedPool(size_t bytes) : m_n_blocks{Blocks(bytes)},
+                                       m_pool{new Block[m_n_blocks]},
+                                       m_roots{nullptr, nullptr},
+                                       m_n_free{0u}
+  {
+    Node *all = reinterpret_cast<Node *>(m_pool);
+    all->m_length = m_n_blocks;
+    this->Insert(all);
+  }
+
+  /// Destructs the IndexedPool.
+  ~IndexedPool()
+  {
+    delete[] m_pool;
+  }
+
+  IndexedPool(const IndexedPool &) = delete;
+  IndexedPool &operator=(const IndexedPool &) = delete;
+
+  void *Allocate(size_t bytes)
+  {
+    void *ptr = this->Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+
+    return ptr;
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
+  {
+    size_t blocks = Blocks(bytes);
+
+    // Smallest free area that fits (the lowest address among equals).
+    Node *best = nullptr;
+    for (Node *node = m_roots[BY_SIZE]; node != nullptr;)
+    {
+      if (node->m_length >= blocks)
+      {
+        best = node;
+        node = node->m_links[BY_SIZE][0];
+      }
+      else
+        node = node->m_links[BY_SIZE][1];
+    }
+
+    if (best == nullptr)
+      return nullptr;
+
+    this->Remove(best);
+    if (best->m_length - blocks >= MIN_BLOCKS)
+    {
+      Node *rest = Advance(best, blocks);
+      rest->m_length = best->m_length - blocks;
+      best->m_length = blocks;
+      this->Insert(rest);
+    }
+
+    return reinterpret_cast<void *>(static_cast<Header *>(best) + (1U));
+  }
+
+  void Free(void *ptr)
+  {
+    Node *current = static_cast<Node *>(reinterpret_cast<Header *>(ptr) - (1U));
+
+    // Free areas right before and right after `current`.
+    Node *pre = nullptr, *pos = nullptr;
+    for (Node *node = m_roots[BY_ADDRESS]; node != nullptr;)
+    {
+      if (node < current)
+      {
+        pre = node;
+        node = node->m_links[BY_ADDRESS][1];
+      }
+      else
+      {
+        pos = node;
+        node = node->m_links[BY_ADDRESS][0];
+      }
+    }
+
+    if (pos != nullptr and Advance(current, current->m_length) == pos)
+    {
+      this->Remove(pos);
+      current->m_length += pos->m_length;
+    }
+
+    if (pre != nullptr and Advance(pre, pre->m_length) == current)
+    {
+      // `pre` keeps its place in the address tree; only its size changes.
+      m_roots[BY_SIZE] = Erase(BY_SIZE, m_roots[BY_SIZE], pre);
+      pre->m_length += current->m_length;
+      m_roots[BY_SIZE] = Insert(BY_SIZE, m_roots[BY_SIZE], pre);
+    }
+    else
+      this->Insert(current);
+  }
+
+  /// Calls `fn(area, bytes)` for every free area, in address order.
+  template <typename Fn>
+  void ForEachFree(Fn fn) const
+  {
+    Visit(m_roots[BY_ADDRESS], fn);
+  }
+
+  /// Number of free areas.
+  size_t FreeAreas() const
+  {
+    return m_n_free;
+  }
+
+  /// Number of bytes the client may use in the area returned by Allocate().
+  static size_t UsableSize(const void *ptr)
+  {
+    return reinterpret_cast<const Header *>(ptr)[-1].m_length * BLK_SZ - HEADER_SZ;
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream, const IndexedPool &obj)
+  {
+    stream << " IndexedPool { blocks: " << obj.m_n_blocks << ", free areas: " << obj.m_n_free << " } " << std::endl;
+
+    return stream;
+  }
+
+private:
+  /// Blocks taken by an area of `bytes` bytes.
+  static size_t Blocks(size_t bytes)
+  {
+    size_t blocks = (bytes + HEADER_SZ + BLK_SZ - 1u) / BLK_SZ;
+    return blocks < MIN_BLOCKS ? MIN_BLOCKS : blocks;
+  }
+
+  static Node *Advance(Node *node, size_t blocks)
+  {
+    return reinterpret_cast<Node *>(reinterpret_cast<Block *>(node) + blocks);
+  }
+
+  void Insert(Node *node)
+  {
+    m_roots[BY_ADDRESS] = Insert(BY_ADDRESS, m_roots[BY_ADDRESS], node);
+    m_roots[BY_SIZE] = Insert(BY_SIZE, m_roots[BY_SIZE], node);
+    ++m_n_free;
+  }
+
+  void Remove(Node *node)
+  {
+    m_roots[BY_ADDRESS] = Erase(BY_ADDRESS, m_roots[BY_ADDRESS], node);
+    m_roots[BY_SIZE] = Erase(BY_SIZE, m_roots[BY_SIZE], node);
+    --m_n_free;
+  }
+
+  static bool Less(int tree, const Node *a, const Node *b)
+  {
+    if (tree == BY_SIZE and a->m_length != b->m_length)
+      return a->m_length < b->m_length;
+    return a < b;
+  }
+
+  /// Treap priority, derived from the address so that it needs no storage.
+  /**
+   * The block index goes through the MurmurHash3 finalizer (fmix64). A plain
+   * multiplicative hash gives monotone priorities to areas spaced a Fibonacci
+   * number of blocks apart, and turns the treaps into lists.
+   */
+  static uint64_t Priority(const Node *node)
+  {
+    uint64_t key = reinterpret_cast<uintptr_t>(node) / BLK_SZ;
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return key;
+  }
+
+  /// Splits `root` into the nodes ordered before `key` (`left`) and the others (`right`).
+  static void Split(int tree, Node *root, const Node *key, Node *&left, Node *&right)
+  {
+    if (root == nullptr)
+      left = right = nullptr;
+    else if (Less(tree, root, key))
+    {
+      Split(tree, root->m_links[tree][1], key, root->m_links[tree][1], right);
+      left = root;
+    }
+    else
+    {
+      Split(tree, root->m_links[tree][0], key, left, root->m_links[tree][0]);
+      right = root;
+    }
+  }
+
+  /// Joins two treaps, every node of `left` being ordered before those of `right`.
+  static Node *Join(int tree, Node *left, Node *right)
+  {
+    if (left == nullptr)
+      return right;
+    if (right == nullptr)
+      return left;
+
+    if (Priority(left) > Priority(right))
+    {
+      left->m_links[tree][1] = Join(tree, left->m_links[tree][1], right);
+      return left;
+    }
+
+    right->m_links[tree][0] = Join(tree, left, right->m_links[tree][0]);
+    return right;
+  }
+
+  static Node *Insert(int tree, Node *root, Node *node)
+  {
+    if (root == nullptr or Priority(node) > Priority(root))
+    {
+      Split(tree, root, node, node->m_links[tree][0], node->m_links[tree][1]);
+      return node;
+    }
+
+    int side = Less(tree, root, node);
+    root->m_links[tree][side] = Insert(tree, root->m_links[tree][side], node);
+    return root;
+  }
+
+  static Node *Erase(int tree, Node *root, const Node *node)
+  {
+    if (root == node)
+      return Join(tree, root->m_links[tree][0], root->m_links[tree][1]);
+
+    int side = Less(tree, root, node);
+    root->m_links[tree][side] = Erase(tree, root->m_links[tree][side], node);
+    return root;
+  }
+
+  template <typename Fn>
+  static void Visit(const Node *node, Fn &fn)
+  {
+    while (node != nullptr)
+    {
+      Visit(node->m_links[BY_ADDRESS][0], fn);
+      fn(static_cast<const void *>(node), node->m_length * BLK_SZ);
+      node = node->m_links[BY_ADDRESS][1];
+    }
+  }
+};
+
+// Needed (before C++17) when MIN_BLOCKS is bound to a reference, as std::max() does.
+template <size_t BLK_SIZE>
+constexpr size_t IndexedPool<BLK_SIZE>::MIN_BLOCKS;
+} // namespace mp
+
+#endif
@@ -0,0 +1,457 @@
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <time.h>
+#include "StoragePool.hpp"
+#include "SLPool.hpp"
+
+#ifndef MAINTAINED_POOL_H
+#define MAINTAINED_POOL_H
+
+namespace mp
+{
+/// Snapshot of the state of a MaintainedPool, published by Maintain().
+struct PoolStats
+{
+  size_t m_allocations = 0u;  //!< Allocate() calls.
+  size_t m_cache_hits = 0u;   //!< Allocate() calls served by a size cache.
+  size_t m_frees = 0u;        //!< Free() calls.
+  size_t m_merged = 0u;       //!< Deferred frees coalesced into the free list.
+  size_t m_recycled = 0u;     //!< Deferred frees put back into a size cache.
+  size_t m_cached_bytes = 0u; //!< Bytes waiting in the size caches.
+  size_t m_free_bytes = 0u;   //!< Bytes in the free list.
+  size_t m_released = 0u;     //!< Bytes given back to the OS so far.
+  size_t m_passes = 0u;       //!< Maintenance passes so far.
+};
+
+/// Thread-safe SLPool whose coalescing, cache refills and trimming can run off the hot path.
+/**
+ * Free() never coalesces: it pushes the area onto a lock-free stack of deferred
+ * frees. Small requests (up to N_CLASSES blocks) are served from per-size caches
+ * of ready-made areas, each behind its own spinlock; everything else goes to the
+ * SLPool under a mutex.
+ *
+ * Maintain() does the rest in one bounded pass: it hands the deferred frees back
+ * to the caches that are short or coalesces them into the free list, resizes each
+ * cache to twice the demand seen since the previous pass, empties the caches and
+ * trims the pool once it has been idle for `purge_after`, and publishes a
+ * PoolStats snapshot. A PoolMaintainer calls it from a background thread. The slow
+ * path of Allocate() (whatever the caches don't serve) also merges the deferred
+ * frees waiting at that moment, and, as a last resort, empties the caches, so
+ * freed memory is reused with or without a worker.
+ */
+template <size_t BLK_SIZE = 16, size_t N_CLASSES = 16>
+class MaintainedPool : public StoragePool
+{
+public:
+  static constexpr size_t BLK_SZ = SLPool<BLK_SIZE>::BLK_SZ;       //!< The block size in bytes.
+  static constexpr size_t HEADER_SZ = SLPool<BLK_SIZE>::HEADER_SZ; //!< The header size in bytes.
+  static constexpr size_t MAX_CACHED = 4096;                       //!< Most areas a single size cache keeps.
+
+  static_assert(BLK_SIZE >= HEADER_SZ + sizeof(void *), "a block must hold the Header and a link");
+
+private:
+  struct Node
+  {
+    Node *m_next;
+  };
+
+  /// Ready-made areas of one length.
+  struct Cache
+  {
+    std::atomic<bool> m_busy{false};  //!< Spinlock of m_head and m_count.
+    Node *m_head = nullptr;
+    size_t m_count = 0u;
+    std::atomic<size_t> m_demand{0u}; //!< Requests since the last maintenance pass.
+    size_t m_target = 0u;             //!< Areas the cache should hold (maintenance only).
+
+    void Lock()
+    {
+      while (m_busy.exchange(true, std::memory_order_acquire))
+        ;
+    }
+
+    void Unlock()
+    {
+      m_busy.store(false, std::memory_order_release);
+    }
+  };
+
+  SLPool<BLK_SIZE> m_pool;          //!< The pool itself (guarded by m_lock).
+  std::mutex m_lock;                //!< Guards m_pool.
+  std::atomic<Node *> m_deferred;   //!< Areas freed but not yet merged, newest first.
+  Cache m_caches[N_CLASSES + 1];    //!< m_caches[n] holds areas of n blocks.
+  std::atomic<size_t> m_allocations;
+  std::atomic<size_t> m_cache_hits;
+  std::atomic<size_t> m_frees;
+  std::atomic<size_t> m_merged;
+
+  std::mutex m_maintain_lock;       //!< Serializes Maintain(); guards the members below.
+  size_t m_recycled;
+  size_t m_released;
+  size_t m_passes;
+  size_t m_activity;                //!< Allocations plus frees seen by the last pass.
+  std::chrono::steady_clock::time_point m_idle_since;
+
+  std::mutex m_stats_lock;          //!< Guards m_stats.
+  PoolStats m_stats;                //!< Last published snapshot.
+
+public:
+  /// Constructor of MaintainedPool, reserves `bytes` bytes.
+  explicit MaintainedPool(size_t bytes) : m_pool(bytes),
+                                          m_deferred(nullptr),
+                                          m_allocations(0u),
+                                          m_cache_hits(0u),
+                                          m_frees(0u),
+                                          m_merged(0u),
+                                          m_recycled(0u),
+                                          m_released(0u),
+                                          m_passes(0u),
+                                          m_activity(0u),
+                                          m_idle_since(std::chrono::steady_clock::now())
+  { /* Empty */
+  }
+
+  MaintainedPool(const MaintainedPool &) = delete;
+  MaintainedPool &operator=(const MaintainedPool &) = delete;
+
+  void *Allocate(size_t bytes)
+  {
+    void *ptr = this->Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+
+    return ptr;
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
+  {
+    const size_t blocks = (bytes + HEADER_SZ + BLK_SZ - 1u) / BLK_SZ;
+    m_allocations.fetch_add(1u, std::memory_order_relaxed);
+
+    if (blocks <= N_CLASSES)
+    {
+      Cache &cache = m_caches[blocks];
+      cache.m_demand.fetch_add(1u, std::memory_order_relaxed);
+
+      cache.Lock();
+      Node *node = cache.m_head;
+      if (node != nullptr)
+      {
+        cache.m_head = node->m_next;
+        --cache.m_count;
+      }
+      cache.Unlock();
+
+      if (node != nullptr)
+      {
+        m_cache_hits.fetch_add(1u, std::memory_order_relaxed);
+        return node;
+      }
+    }
+
+    // Areas freed since the last merge are reused before the rest of the free list is walked.
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_deferred.load(std::memory_order_relaxed) != nullptr)
+      this->MergeDeferred();
+    void *ptr = m_pool.Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+    {
+      for (size_t n = 1u; n <= N_CLASSES; ++n)
+        this->Shrink(m_caches[n], 0u);
+      ptr = m_pool.Allocate(bytes, std::nothrow);
+    }
+
+    return ptr;
+  }
+
+  void Free(void *ptr)
+  {
+    m_frees.fetch_add(1u, std::memory_order_relaxed);
+
+    Node *node = reinterpret_cast<Node *>(ptr);
+    node->m_next = m_deferred.load(std::memory_order_relaxed);
+    while (not m_deferred.compare_exchange_weak(node->m_next, node, std::memory_order_release, std::memory_order_relaxed))
+      ;
+  }
+
+  /// Runs one maintenance pass (see the class description); the pool is trimmed after `purge_after` without traffic.
+  void Maintain(std::chrono::steady_clock::duration purge_after = std::chrono::seconds(1))
+  {
+    std::lock_guard<std::mutex> maintaining(m_maintain_lock);
+    const auto now = std::chrono::steady_clock::now();
+
+    // Deferred frees go back to their cache while it is short, or to the free list.
+    Node *merge = nullptr;
+    for (Node *node = m_deferred.exchange(nullptr, std::memory_order_acquire), *next; node != nullptr; node = next)
+    {
+      next = node->m_next;
+      size_t blocks = Blocks(node);
+      if (blocks <= N_CLASSES and this->Offer(m_caches[blocks], node))
+        ++m_recycled;
+      else
+      {
+        node->m_next = merge;
+        merge = node;
+      }
+    }
+    if (merge != nullptr)
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_merged.fetch_add(this->FreeAll(merge), std::memory_order_relaxed);
+    }
+
+    size_t activity = m_allocations.load(std::memory_order_relaxed) + m_frees.load(std::memory_order_relaxed);
+    if (activity != m_activity)
+    {
+      m_activity = activity;
+      m_idle_since = now;
+    }
+    const bool idle = now - m_idle_since >= purge_after;
+
+    // Each cache is sized after the demand since the last pass, and emptied once the pool is idle.
+    for (size_t n = 1u; n <= N_CLASSES; ++n)
+    {
+      Cache &cache = m_caches[n];
+      size_t demand = cache.m_demand.exchange(0u, std::memory_order_relaxed);
+      cache.m_target = idle ? 0u : std::min(std::max(2u * demand, cache.m_target / 2u), MAX_CACHED);
+
+      std::lock_guard<std::mutex> guard(m_lock);
+      this->Shrink(cache, cache.m_target);
+      this->Refill(cache, n, cache.m_target);
+    }
+
+    size_t free_bytes = 0u;
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      if (idle and m_pool.DirtyBytes() > 0u)
+        m_released += m_pool.Trim();
+      m_pool.ForEachFree([&free_bytes](const void *, size_t bytes) { free_bytes += bytes; });
+    }
+
+    PoolStats stats;
+    stats.m_allocations = m_allocations.load(std::memory_order_relaxed);
+    stats.m_cache_hits = m_cache_hits.load(std::memory_order_relaxed);
+    stats.m_frees = m_frees.load(std::memory_order_relaxed);
+    stats.m_merged = m_merged.load(std::memory_order_relaxed);
+    stats.m_recycled = m_recycled;
+    for (size_t n = 1u; n <= N_CLASSES; ++n)
+    {
+      m_caches[n].Lock();
+      stats.m_cached_bytes += m_caches[n].m_count * n * BLK_SZ;
+      m_caches[n].Unlock();
+    }
+    stats.m_free_bytes = free_bytes;
+    stats.m_released = m_released;
+    stats.m_passes = ++m_passes;
+
+    std::lock_guard<std::mutex> guard(m_stats_lock);
+    m_stats = stats;
+  }
+
+  /// Last snapshot published by Maintain().
+  PoolStats Stats()
+  {
+    std::lock_guard<std::mutex> guard(m_stats_lock);
+    return m_stats;
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream, const MaintainedPool &obj)
+  {
+    stream << " MaintainedPool { size classes: " << N_CLASSES << " } " << std::endl;
+
+    return stream;
+  }
+
+private:
+  static size_t Blocks(const Node *node)
+  {
+    return (SLPool<BLK_SIZE>::UsableSize(node) + HEADER_SZ) / BLK_SZ;
+  }
+
+  /// Frees a list of areas into the pool, returning how many there were (m_lock held).
+  size_t FreeAll(Node *node)
+  {
+    size_t count = 0u;
+    for (Node *next; node != nullptr; node = next, ++count)
+    {
+      next = node->m_next;
+      m_pool.Free(node);
+    }
+
+    return count;
+  }
+
+  /// Merges every deferred free into the free list (m_lock held).
+  void MergeDeferred()
+  {
+    m_merged.fetch_add(this->FreeAll(m_deferred.exchange(nullptr, std::memory_order_acquire)), std::memory_order_relaxed);
+  }
+
+  /// Pushes `node` onto `cache` if the cache is below its target.
+  bool Offer(Cache &cache, Node *node)
+  {
+    cache.Lock();
+    bool taken = cache.m_count < cache.m_target;
+    if (taken)
+    {
+      node->m_next = cache.m_head;
+      cache.m_head = node;
+      ++cache.m_count;
+    }
+    cache.Unlock();
+
+    return taken;
+  }
+
+  /// Gives the areas of `cache` beyond `count` back to the free list (m_lock held).
+  void Shrink(Cache &cache, size_t count)
+  {
+    Node *surplus = nullptr;
+    cache.Lock();
+    while (cache.m_count > count)
+    {
+      Node *node = cache.m_head;
+      cache.m_head = node->m_next;
+      --cache.m_count;
+      node->m_next = surplus;
+      surplus = node;
+    }
+    cache.Unlock();
+
+    this->FreeAll(surplus);
+  }
+
+  /// Reserves areas of `blocks` blocks until `cache` holds `count` of them (m_lock held).
+  void Refill(Cache &cache, size_t blocks, size_t count)
+  {
+    cache.Lock();
+    size_t missing = count > cache.m_count ? count - cache.m_count : 0u;
+    cache.Unlock();
+
+    while (missing-- > 0u)
+    {
+      Node *node = reinterpret_cast<Node *>(m_pool.Allocate(blocks * BLK_SZ - HEADER_SZ, std::nothrow));
+      if (node == nullptr)
+        break;
+
+      cache.Lock();
+      node->m_next = cache.m_head;
+      cache.m_head = node;
+      ++cache.m_count;
+      cache.Unlock();
+    }
+  }
+};
+
+// Needed (before C++17) when MAX_CACHED is bound to a reference, as std::min() does.
+template <size_t BLK_SIZE, size_t N_CLASSES>
+constexpr size_t MaintainedPool<BLK_SIZE, N_CLASSES>::MAX_CACHED;
+
+/// Background thread that calls Maintain() on one or more pools, within a CPU budget.
+/**
+ * The worker runs a pass over every pool each `period`, but sleeps longer when a
+ * pass was expensive, so that it never uses more than `cpu_budget` (a fraction of
+ * one CPU) on average. Its CPU time is measured with the thread CPU clock.
+ * The pools must outlive the maintainer.
+ */
+template <typename Pool>
+class PoolMaintainer
+{
+private:
+  std::vector<Pool *> m_pools;              //!< Pools being maintained.
+  std::chrono::nanoseconds m_period;        //!< Shortest time between two passes.
+  double m_cpu_budget;                      //!< Fraction of a CPU the worker may use.
+  std::chrono::nanoseconds m_purge_after;   //!< Idle time after which a pool is trimmed.
+  std::chrono::nanoseconds m_cpu_time;      //!< CPU time used so far (guarded by m_lock).
+  bool m_stop;                              //!< Whether the thread must finish (guarded by m_lock).
+  std::mutex m_lock;                        //!< Guards the maintainer's own state.
+  std::condition_variable m_wake;           //!< Signals m_stop.
+  std::thread m_thread;                     //!< The worker.
+
+public:
+  /// Constructor of PoolMaintainer, starts the worker over `pools`; throws std::invalid_argument unless 0 < `cpu_budget` <= 1.
+  PoolMaintainer(std::vector<Pool *> pools,
+                 std::chrono::milliseconds period = std::chrono::milliseconds(10),
+                 double cpu_budget = 0.05,
+                 std::chrono::milliseconds purge_after = std::chrono::milliseconds(1000))
+      : m_pools(pools), m_period(period), m_cpu_budget(cpu_budget), m_purge_after(purge_after), m_cpu_time(0), m_stop(false)
+  {
+    if (not(cpu_budget > 0.0 and cpu_budget <= 1.0))
+      throw std::invalid_argument("PoolMaintainer: the CPU budget must be in (0, 1]");
+
+    m_thread = std::thread(&PoolMaintainer::Run, this);
+  }
+
+  /// Constructor of PoolMaintainer, starts the worker over a single pool.
+  explicit PoolMaintainer(Pool &pool,
+                          std::chrono::milliseconds period = std::chrono::milliseconds(10),
+                          double cpu_budget = 0.05,
+                          std::chrono::milliseconds purge_after = std::chrono::milliseconds(1000))
+      : PoolMaintainer(std::vector<Pool *>(1u, &pool), period, cpu_budget, purge_after)
+  { /* Empty */
+  }
+
+  /// Stops and joins the worker.
+  ~PoolMaintainer()
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+  }
+
+  PoolMaintainer(const PoolMaintainer &) = delete;
+  PoolMaintainer &operator=(const PoolMaintainer &) = delete;
+
+  /// CPU time used by the worker so far.
+  std::chrono::nanoseconds CpuTime()
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_cpu_time;
+  }
+
+private:
+  static std::chrono::nanoseconds ThreadCpuTime()
+  {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+  }
+
+  void Run()
+  {
+    std::chrono::nanoseconds wait = m_period;
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    while (not m_wake.wait_for(guard, wait, [this] { return m_stop; }))
+    {
+      guard.unlock();
+
+      const auto start = ThreadCpuTime();
+      for (Pool *pool : m_pools)
+        pool->Maintain(m_purge_after);
+      const auto busy = ThreadCpuTime() - start;
+
+      guard.lock();
+      m_cpu_time += busy;
+
+      // Sleep long enough for busy / (busy + sleep) to stay within the budget.
+      auto rest = std::chrono::duration_cast<std::chrono::nanoseconds>(busy * ((1.0 - m_cpu_budget) / m_cpu_budget));
+      wait = std::max(m_period, rest);
+    }
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,118 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+#include "StoragePool.hpp"
+
+#ifndef NODE_SLAB_H
+#define NODE_SLAB_H
+
+namespace mp
+{
+/// Node allocator for the pool containers: carves nodes out of slabs reserved from a StoragePool.
+/**
+ * Nodes are reserved SLAB_NODES at a time with a single Allocate() call, so nodes
+ * created one after the other end up next to each other in memory. Destroyed nodes
+ * go to a free list that is reused before the slabs grow; the slabs themselves go
+ * back to the pool when the NodeSlab is destroyed.
+ *
+ * The containers built on it keep the links and the value in one node, as an
+ * intrusive container would, but they create the nodes themselves: an intrusive
+ * container links objects its caller has already placed, and could neither take
+ * them from a given pool nor cluster them.
+ *
+ * Pools only promise pointer alignment (an SLPool area follows an 8-byte header),
+ * so slabs of over-aligned nodes are reserved with some slack and aligned by hand.
+ */
+template <typename Node, size_t SLAB_NODES = 64>
+class NodeSlab
+{
+private:
+  union Slot {
+    Slot *m_next;                                 // Next free slot OR...
+    alignas(Node) unsigned char m_raw[sizeof(Node)]; // a node.
+  };
+
+  struct Slab
+  {
+    Slab *m_next;               //!< Previously reserved slab.
+    void *m_area;               //!< Area reserved from the pool (the slab starts at or after it).
+    Slot m_slots[SLAB_NODES];   //!< The nodes.
+  };
+
+  static constexpr size_t POOL_ALIGN = alignof(void *);                                        //!< Alignment of the areas of any pool.
+  static constexpr size_t SLACK = alignof(Slab) > POOL_ALIGN ? alignof(Slab) - POOL_ALIGN : 0u; //!< Bytes needed to align a slab in such an area.
+
+  StoragePool &m_pool; //!< Where the slabs come from.
+  Slab *m_slabs;       //!< Reserved slabs, newest first.
+  Slot *m_free;        //!< Slots of destroyed nodes.
+  size_t m_fresh;      //!< Slots of the newest slab never handed out yet.
+
+public:
+  explicit NodeSlab(StoragePool &pool) : m_pool(pool), m_slabs(nullptr), m_free(nullptr), m_fresh(0u)
+  { /* Empty */
+  }
+
+  /// Returns every slab to the pool; the nodes must have been destroyed already.
+  ~NodeSlab()
+  {
+    while (m_slabs != nullptr)
+    {
+      Slab *next = m_slabs->m_next;
+      m_pool.Free(m_slabs->m_area);
+      m_slabs = next;
+    }
+  }
+
+  NodeSlab(const NodeSlab &) = delete;
+  NodeSlab &operator=(const NodeSlab &) = delete;
+
+  StoragePool &Pool() const
+  {
+    return m_pool;
+  }
+
+  template <typename... Args>
+  Node *Create(Args &&... args)
+  {
+    Slot *slot = m_free;
+    if (slot != nullptr)
+      m_free = slot->m_next;
+    else
+    {
+      if (m_fresh == 0u)
+      {
+        void *area = m_pool.Allocate(sizeof(Slab) + SLACK);
+        Slab *slab = reinterpret_cast<Slab *>((reinterpret_cast<uintptr_t>(area) + alignof(Slab) - 1u) & ~(alignof(Slab) - 1u));
+        slab->m_area = area;
+        slab->m_next = m_slabs;
+        m_slabs = slab;
+        m_fresh = SLAB_NODES;
+      }
+      slot = &m_slabs->m_slots[SLAB_NODES - m_fresh--];
+    }
+
+    try
+    {
+      return new (slot->m_raw) Node(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      slot->m_next = m_free;
+      m_free = slot;
+      throw;
+    }
+  }
+
+  void Destroy(Node *node)
+  {
+    node->~Node();
+
+    Slot *slot = reinterpret_cast<Slot *>(node);
+    slot->m_next = m_free;
+    m_free = slot;
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,253 @@
+#include <stddef.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "StoragePool.hpp"
+#include "SLPool.hpp"
+
+#ifndef NUMA_POOL_SET_H
+#define NUMA_POOL_SET_H
+
+namespace mp
+{
+/// NUMA nodes of the machine and the node of each CPU, as listed under /sys/devices/system/node.
+struct NumaTopology
+{
+  std::vector<int> m_nodes;    //!< Ids of the online nodes.
+  std::vector<size_t> m_cpus;  //!< Index (into m_nodes) of the node of each CPU.
+
+  /// Reads the topology from `root`; a machine without that directory is seen as a single node.
+  static NumaTopology Detect(const std::string &root = "/sys/devices/system/node")
+  {
+    NumaTopology topology;
+
+    std::ifstream online(root + "/online");
+    std::string list;
+    if (online >> list)
+      topology.m_nodes = ParseList(list);
+    if (topology.m_nodes.empty())
+      topology.m_nodes.push_back(0);
+
+    for (size_t i = 0u; i < topology.m_nodes.size(); ++i)
+    {
+      std::ifstream cpulist(root + "/node" + std::to_string(topology.m_nodes[i]) + "/cpulist");
+      if (not(cpulist >> list))
+        continue;
+
+      for (int cpu : ParseList(list))
+      {
+        if (size_t(cpu) >= topology.m_cpus.size())
+          topology.m_cpus.resize(cpu + 1, 0u);
+        topology.m_cpus[cpu] = i;
+      }
+    }
+
+    return topology;
+  }
+
+  /// Parses a kernel list such as "0-3,8,10-11".
+  static std::vector<int> ParseList(const std::string &list)
+  {
+    std::vector<int> values;
+    std::istringstream ranges(list);
+    std::string range;
+
+    while (std::getline(ranges, range, ','))
+    {
+      int first, last;
+      char dash;
+      std::istringstream bounds(range);
+      if (not(bounds >> first))
+        continue;
+      if (not(bounds >> dash >> last) or dash != '-')
+        last = first;
+      for (int value = first; value <= last; ++value)
+        values.push_back(value);
+    }
+
+    return values;
+  }
+};
+
+/// Set of SLPool arenas, one per NUMA node, that serves each thread from its own node.
+/**
+ * Each arena is an anonymous mapping bound to its node with mbind(MPOL_PREFERRED)
+ * before any page is touched. When the binding is refused (single-node kernels,
+ * containers without the capability), pages simply follow first-touch, which the
+ * node-local allocation policy keeps mostly local anyway. An allocation goes to the
+ * arena of the node the calling thread runs on, and spills over to the other nodes
+ * when that arena is full. Free() finds the owning arena from the address, so areas
+ * may be freed from any node. Every arena has its own lock.
+ */
+template <size_t BLK_SIZE = 16>
+class NumaPoolSet : public StoragePool
+{
+private:
+  /// Anonymous mapping, unmapped when destroyed.
+  struct Mapping
+  {
+    char *m_begin; //!< First byte of the mapping.
+    char *m_end;   //!< One past the last byte of the mapping.
+
+    explicit Mapping(size_t bytes)
+    {
+      void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED)
+        throw std::bad_alloc();
+
+      m_begin = reinterpret_cast<char *>(base);
+      m_end = m_begin + bytes;
+    }
+
+    ~Mapping()
+    {
+      munmap(m_begin, m_end - m_begin);
+    }
+
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+  };
+
+  struct Arena
+  {
+    std::mutex m_lock;          //!< Guards m_pool.
+    Mapping m_mapping;          //!< Memory of the arena; outlives m_pool.
+    bool m_bound;               //!< Whether mbind() accepted the node.
+    SLPool<BLK_SIZE> m_pool;    //!< The arena itself.
+
+    Arena(size_t bytes, int node, bool bind) : m_mapping(bytes),
+                                               m_bound(bind and Bind(m_mapping.m_begin, bytes, node)),
+                                               m_pool(m_mapping.m_begin, bytes)
+    { /* Empty */
+    }
+  };
+
+  NumaTopology m_topology;                     //!< Nodes and CPU to node map.
+  std::vector<std::unique_ptr<Arena>> m_arenas; //!< One arena per node, in m_topology.m_nodes order.
+
+public:
+  /// Constructor of NumaPoolSet, maps `bytes` bytes (at most) on every node.
+  explicit NumaPoolSet(size_t bytes, const NumaTopology &topology = NumaTopology::Detect()) : m_topology(topology)
+  {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    bytes = (bytes + SLPool<BLK_SIZE>::HEADER_SZ + 2u * SLPool<BLK_SIZE>::BLK_SZ + page - 1u) / page * page;
+
+    // An arena owns its mapping, so the ones already made are unmapped if a later one throws.
+    for (int node : m_topology.m_nodes)
+    {
+      std::unique_ptr<Arena> arena(new Arena(bytes, node, m_topology.m_nodes.size() > 1u));
+      m_arenas.push_back(std::move(arena));
+    }
+  }
+
+  NumaPoolSet(const NumaPoolSet &) = delete;
+  NumaPoolSet &operator=(const NumaPoolSet &) = delete;
+
+  void *Allocate(size_t bytes)
+  {
+    void *ptr = this->Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+
+    return ptr;
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
+  {
+    return this->AllocateOn(this->CurrentNode(), bytes);
+  }
+
+  /// Allocates from the arena of node `node` (an index into Nodes()), spilling over to the others; nullptr when every arena is full.
+  void *AllocateOn(size_t node, size_t bytes) noexcept
+  {
+    for (size_t i = 0u; i < m_arenas.size(); ++i)
+    {
+      Arena &arena = *m_arenas[(node + i) % m_arenas.size()];
+      std::lock_guard<std::mutex> guard(arena.m_lock);
+
+      void *ptr = arena.m_pool.Allocate(bytes, std::nothrow);
+      if (ptr != nullptr)
+        return ptr;
+    }
+
+    return nullptr;
+  }
+
+  /// Returns `ptr` to the arena that owns it; throws std::invalid_argument if no arena does.
+  void Free(void *ptr)
+  {
+    int node = this->NodeOf(ptr);
+    if (node < 0)
+      throw std::invalid_argument("NumaPoolSet::Free: pointer not from this pool set");
+
+    Arena &arena = *m_arenas[node];
+    std::lock_guard<std::mutex> guard(arena.m_lock);
+    arena.m_pool.Free(ptr);
+  }
+
+  /// Index of the arena (node) that owns `ptr`, or -1 if it came from none of them.
+  int NodeOf(const void *ptr) const
+  {
+    const char *byte = reinterpret_cast<const char *>(ptr);
+    for (size_t i = 0u; i < m_arenas.size(); ++i)
+      if (byte >= m_arenas[i]->m_mapping.m_begin and byte < m_arenas[i]->m_mapping.m_end)
+        return int(i);
+
+    return -1;
+  }
+
+  /// Index of the node the calling thread runs on.
+  size_t CurrentNode() const
+  {
+    int cpu = sched_getcpu();
+    return cpu >= 0 and size_t(cpu) < m_topology.m_cpus.size() ? m_topology.m_cpus[cpu] : 0u;
+  }
+
+  /// Ids of the nodes, one arena each.
+  const std::vector<int> &Nodes() const
+  {
+    return m_topology.m_nodes;
+  }
+
+  /// Whether the arena of node `node` (an index into Nodes()) was bound with mbind().
+  bool Bound(size_t node) const
+  {
+    return m_arenas[node]->m_bound;
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream, const NumaPoolSet &obj)
+  {
+    stream << " NumaPoolSet { nodes: " << obj.m_arenas.size() << " } " << std::endl;
+
+    return stream;
+  }
+
+private:
+  /// Asks the kernel to place the pages of [base, base + bytes) on `node`.
+  static bool Bind(void *base, size_t bytes, int node)
+  {
+#ifdef SYS_mbind
+    const int MPOL_PREFERRED = 1;
+    const size_t WORD_BITS = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / WORD_BITS + 1u, 0ul);
+    mask[node / WORD_BITS] = 1ul << (node % WORD_BITS);
+
+    return syscall(SYS_mbind, base, bytes, MPOL_PREFERRED, mask.data(), mask.size() * WORD_BITS + 1u, 0u) == 0;
+#else
+    return false;
+#endif
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,170 @@
+#include <stddef.h>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include "StoragePool.hpp"
+#include "NodeSlab.hpp"
+
+#ifndef POOL_HASH_MAP_H
+#define POOL_HASH_MAP_H
+
+namespace mp
+{
+/// Chained hash map whose nodes and bucket array are reserved from a StoragePool.
+/**
+ * Nodes are clustered in slabs (see NodeSlab), and each node keeps the full hash of
+ * its key, so a lookup only compares keys whose hashes match and a rehash never
+ * calls the hash function again. The bucket array doubles when the load factor
+ * goes over 1.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class PoolHashMap
+{
+private:
+  struct Node
+  {
+    Node *m_next;
+    size_t m_hash;
+    Key m_key;
+    Value m_value;
+
+    template <typename K, typename... Args>
+    Node(size_t hash, K &&key, Args &&... args) : m_next(nullptr), m_hash(hash), m_key(std::forward<K>(key)), m_value(std::forward<Args>(args)...)
+    { /* Empty */
+    }
+  };
+
+  NodeSlab<Node> m_nodes; //!< Node allocator.
+  Node **m_buckets;       //!< Bucket array, reserved from the same pool.
+  size_t m_n_buckets;     //!< Number of buckets (a power of two).
+  size_t m_size;          //!< Number of entries.
+  Hash m_hash;
+  Equal m_equal;
+
+public:
+  explicit PoolHashMap(StoragePool &pool, size_t n_buckets = 16u) : m_nodes(pool), m_buckets(nullptr), m_n_buckets(0u), m_size(0u)
+  {
+    size_t n = 1u;
+    while (n < n_buckets)
+      n <<= 1;
+    this->Rehash(n);
+  }
+
+  ~PoolHashMap()
+  {
+    this->Clear();
+    m_nodes.Pool().Free(m_buckets);
+  }
+
+  PoolHashMap(const PoolHashMap &) = delete;
+  PoolHashMap &operator=(const PoolHashMap &) = delete;
+
+  size_t Size() const { return m_size; }
+  bool Empty() const { return m_size == 0u; }
+
+  /// Returns the value stored under `key`, or nullptr.
+  Value *Find(const Key &key)
+  {
+    size_t hash = m_hash(key);
+    for (Node *node = m_buckets[hash & (m_n_buckets - 1u)]; node != nullptr; node = node->m_next)
+      if (node->m_hash == hash and m_equal(node->m_key, key))
+        return &node->m_value;
+
+    return nullptr;
+  }
+
+  const Value *Find(const Key &key) const
+  {
+    return const_cast<PoolHashMap *>(this)->Find(key);
+  }
+
+  /// Inserts `key` with a value built from `args` unless it is already there; returns the stored value and whether it was inserted.
+  template <typename K, typename... Args>
+  std::pair<Value *, bool> Emplace(K &&key, Args &&... args)
+  {
+    size_t hash = m_hash(key);
+    Node **bucket = &m_buckets[hash & (m_n_buckets - 1u)];
+    for (Node *node = *bucket; node != nullptr; node = node->m_next)
+      if (node->m_hash == hash and m_equal(node->m_key, key))
+        return std::make_pair(&node->m_value, false);
+
+    Node *node = m_nodes.Create(hash, std::forward<K>(key), std::forward<Args>(args)...);
+    node->m_next = *bucket;
+    *bucket = node;
+
+    if (++m_size > m_n_buckets)
+      this->Rehash(2u * m_n_buckets);
+
+    return std::make_pair(&node->m_value, true);
+  }
+
+  Value &operator[](const Key &key)
+  {
+    return *this->Emplace(key).first;
+  }
+
+  /// Removes `key`; returns whether it was there.
+  bool Erase(const Key &key)
+  {
+    size_t hash = m_hash(key);
+    for (Node **link = &m_buckets[hash & (m_n_buckets - 1u)]; *link != nullptr; link = &(*link)->m_next)
+    {
+      Node *node = *link;
+      if (node->m_hash == hash and m_equal(node->m_key, key))
+      {
+        *link = node->m_next;
+        m_nodes.Destroy(node);
+        --m_size;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// Calls `fn(key, value)` for every entry, in no particular order.
+  template <typename Fn>
+  void ForEach(Fn fn)
+  {
+    for (size_t i = 0u; i < m_n_buckets; ++i)
+      for (Node *node = m_buckets[i]; node != nullptr; node = node->m_next)
+        fn(node->m_key, node->m_value);
+  }
+
+  void Clear()
+  {
+    for (size_t i = 0u; i < m_n_buckets; ++i)
+      while (m_buckets[i] != nullptr)
+      {
+        Node *node = m_buckets[i];
+        m_buckets[i] = node->m_next;
+        m_nodes.Destroy(node);
+      }
+
+    m_size = 0u;
+  }
+
+private:
+  void Rehash(size_t n_buckets)
+  {
+    Node **buckets = reinterpret_cast<Node **>(m_nodes.Pool().Allocate(n_buckets * sizeof(Node *)));
+    std::memset(buckets, 0, n_buckets * sizeof(Node *));
+
+    for (size_t i = 0u; i < m_n_buckets; ++i)
+      while (m_buckets[i] != nullptr)
+      {
+        Node *node = m_buckets[i];
+        m_buckets[i] = node->m_next;
+        node->m_next = buckets[node->m_hash & (n_buckets - 1u)];
+        buckets[node->m_hash & (n_buckets - 1u)] = node;
+      }
+
+    if (m_buckets != nullptr)
+      m_nodes.Pool().Free(m_buckets);
+    m_buckets = buckets;
+    m_n_buckets = n_buckets;
+  }
+};
+} // namespace mp
+
+#endif
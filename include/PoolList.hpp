@@ -0,0 +1,158 @@
+#include <stddef.h>
+#include <iterator>
+#include <utility>
+#include "StoragePool.hpp"
+#include "NodeSlab.hpp"
+
+#ifndef POOL_LIST_H
+#define POOL_LIST_H
+
+namespace mp
+{
+/// Doubly linked list whose nodes are clustered in slabs reserved from a StoragePool.
+template <typename T>
+class PoolList
+{
+private:
+  struct Link
+  {
+    Link *m_prev;
+    Link *m_next;
+  };
+
+  struct Node : public Link
+  {
+    T m_value;
+
+    template <typename... Args>
+    explicit Node(Args &&... args) : Link(), m_value(std::forward<Args>(args)...)
+    { /* Empty */
+    }
+  };
+
+  NodeSlab<Node> m_nodes; //!< Node allocator.
+  Link m_head;            //!< Sentinel: m_head.m_next is the first node, m_head.m_prev the last.
+  size_t m_size;          //!< Number of nodes.
+
+public:
+  template <typename Value, typename LinkPtr>
+  class Iterator
+  {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value *pointer;
+    typedef Value &reference;
+
+    explicit Iterator(LinkPtr link = nullptr) : m_link(link) {}
+
+    reference operator*() const { return static_cast<Node *>(const_cast<Link *>(m_link))->m_value; }
+    pointer operator->() const { return &**this; }
+
+    Iterator &operator++()
+    {
+      m_link = m_link->m_next;
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator old(*this);
+      m_link = m_link->m_next;
+      return old;
+    }
+
+    Iterator &operator--()
+    {
+      m_link = m_link->m_prev;
+      return *this;
+    }
+
+    Iterator operator--(int)
+    {
+      Iterator old(*this);
+      m_link = m_link->m_prev;
+      return old;
+    }
+
+    bool operator==(const Iterator &other) const { return m_link == other.m_link; }
+    bool operator!=(const Iterator &other) const { return m_link != other.m_link; }
+
+  private:
+    friend class PoolList;
+    LinkPtr m_link;
+  };
+
+  typedef Iterator<T, Link *> iterator;
+  typedef Iterator<const T, const Link *> const_iterator;
+
+  explicit PoolList(StoragePool &pool) : m_nodes(pool), m_size(0u)
+  {
+    m_head.m_prev = m_head.m_next = &m_head;
+  }
+
+  ~PoolList()
+  {
+    this->Clear();
+  }
+
+  PoolList(const PoolList &) = delete;
+  PoolList &operator=(const PoolList &) = delete;
+
+  iterator begin() { return iterator(m_head.m_next); }
+  iterator end() { return iterator(&m_head); }
+  const_iterator begin() const { return const_iterator(m_head.m_next); }
+  const_iterator end() const { return const_iterator(&m_head); }
+
+  size_t Size() const { return m_size; }
+  bool Empty() const { return m_size == 0u; }
+
+  T &Front() { return *begin(); }
+  T &Back() { return *iterator(m_head.m_prev); }
+
+  /// Inserts a new element before `pos`.
+  template <typename... Args>
+  iterator Emplace(iterator pos, Args &&... args)
+  {
+    Node *node = m_nodes.Create(std::forward<Args>(args)...);
+    Link *next = pos.m_link;
+
+    node->m_prev = next->m_prev;
+    node->m_next = next;
+    next->m_prev->m_next = node;
+    next->m_prev = node;
+    ++m_size;
+
+    return iterator(node);
+  }
+
+  void PushBack(const T &value) { this->Emplace(end(), value); }
+  void PushFront(const T &value) { this->Emplace(begin(), value); }
+
+  /// Removes the element at `pos`, returning the one after it.
+  iterator Erase(iterator pos)
+  {
+    Link *link = pos.m_link;
+    Link *next = link->m_next;
+
+    link->m_prev->m_next = next;
+    next->m_prev = link->m_prev;
+    m_nodes.Destroy(static_cast<Node *>(link));
+    --m_size;
+
+    return iterator(next);
+  }
+
+  void PopFront() { this->Erase(begin()); }
+  void PopBack() { this->Erase(iterator(m_head.m_prev)); }
+
+  void Clear()
+  {
+    while (not this->Empty())
+      this->PopBack();
+  }
+};
+} // namespace mp
+
+#endif
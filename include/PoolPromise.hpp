@@ -0,0 +1,90 @@
+#include <stddef.h>
+#include <new>
+#include "StoragePool.hpp"
+#include "BitmapPool.hpp"
+#include "RemoteFreePool.hpp"
+#include "mempool_common.h"
+
+#ifndef POOL_PROMISE_H
+#define POOL_PROMISE_H
+
+namespace mp
+{
+constexpr size_t FRAME_CLASS_SZ = 1u << 20; //!< Bytes reserved by each size class of FramePool(), per thread.
+
+/// Size class of the calling thread for coroutine frames of up to BLK_SIZE bytes (Tag included).
+template <size_t BLK_SIZE>
+StoragePool &FrameClass()
+{
+  static thread_local RemoteFreePool<BLK_SIZE, BitmapPool> pool(FRAME_CLASS_SZ);
+  return pool;
+}
+
+/// Pool that serves a coroutine frame of `bytes` bytes on the calling thread when no pool is passed explicitly.
+/**
+ * Frames are sorted into size classes of 128, 256, 512 and 1024 bytes (Tag included),
+ * each a fixed-block BitmapPool set up on first use: any free slot of the class fits,
+ * so a frame is served without a search through free areas of every size, and freeing
+ * one never splits or merges anything. Returns nullptr for frames larger than that.
+ *
+ * Frames may be destroyed on any thread (they are returned through the class's
+ * remote-free stack), but must be gone before the thread that created them exits.
+ */
+inline StoragePool *FramePool(size_t bytes)
+{
+  bytes += sizeof(Tag);
+  if (bytes <= 128u)
+    return &FrameClass<128>();
+  if (bytes <= 256u)
+    return &FrameClass<256>();
+  if (bytes <= 512u)
+    return &FrameClass<512>();
+  if (bytes <= 1024u)
+    return &FrameClass<1024>();
+
+  return nullptr;
+}
+
+/// Mixin for coroutine promise types that takes the coroutine frames from GREMLINS pools.
+/**
+ * Derive the promise type from PoolPromise. A coroutine whose first parameter is a
+ * StoragePool& (or its second one, for member coroutines) gets its frame from that
+ * pool; every other coroutine uses FramePool(), falling back to the global heap when
+ * its class is full or the frame is too large. Frames are tagged like any other area,
+ * so the global operator delete of mempool_common.h sends each one back to where it
+ * came from. The coroutine's arguments reach operator new by reference, so they are
+ * neither copied nor moved.
+ *
+ * Unoptimized GCC builds warn (-Wmismatched-new-delete) on coroutines that are passed
+ * a pool: GCC pairs no operator delete with a template operator new. The warning is
+ * spurious; build such code with -Wno-mismatched-new-delete.
+ */
+struct PoolPromise
+{
+  template <typename... Args>
+  static void *operator new(size_t bytes, StoragePool &pool, Args &&...)
+  {
+    return ::operator new(bytes, pool);
+  }
+
+  template <typename Class, typename... Args>
+  static void *operator new(size_t bytes, Class &, StoragePool &pool, Args &&...)
+  {
+    return ::operator new(bytes, pool);
+  }
+
+  static void *operator new(size_t bytes)
+  {
+    StoragePool *pool = FramePool(bytes);
+    void *frame = pool != nullptr ? ::operator new(bytes, *pool, std::nothrow) : nullptr;
+    return frame != nullptr ? frame : ::operator new(bytes);
+  }
+
+  static void operator delete(void *frame) noexcept
+  {
+    ::operator delete(frame);
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,107 @@
+#include <stddef.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sys/mman.h>
+
+#ifndef POOL_PURGER_H
+#define POOL_PURGER_H
+
+namespace mp
+{
+/// Background thread that trims a pool once nothing has been freed in it for `decay`.
+/**
+ * The purger wakes up four times per decay period. Each time it sees the dirty
+ * bytes of the pool grow it starts its clock over; once they have stayed put for
+ * `decay`, the pool is trimmed. A pool under steady traffic therefore keeps its
+ * pages (and pays no syscalls for them), while a pool that went quiet after a
+ * spike shrinks shortly after.
+ *
+ * The pool is not thread-safe, so the purger takes `lock` around every access; the
+ * client must hold the same lock around its own Allocate()/Free() calls.
+ */
+template <typename Pool>
+class PoolPurger
+{
+private:
+  Pool &m_pool;                          //!< The pool being trimmed.
+  std::mutex &m_pool_lock;               //!< Lock that guards m_pool.
+  std::chrono::milliseconds m_decay;     //!< How long freed memory may stay resident.
+  int m_advice;                          //!< madvise() advice used by Trim().
+  size_t m_released;                     //!< Bytes released so far (guarded by m_lock).
+  bool m_stop;                           //!< Whether the thread must finish (guarded by m_lock).
+  std::mutex m_lock;                     //!< Guards the purger's own state.
+  std::condition_variable m_wake;        //!< Signals m_stop.
+  std::thread m_thread;                  //!< The purging thread.
+
+public:
+  /// Constructor of PoolPurger, starts the purging thread.
+  PoolPurger(Pool &pool, std::mutex &lock, std::chrono::milliseconds decay, int advice = MADV_DONTNEED)
+      : m_pool(pool), m_pool_lock(lock), m_decay(decay), m_advice(advice), m_released(0u), m_stop(false)
+  {
+    m_thread = std::thread(&PoolPurger::Run, this);
+  }
+
+  /// Stops and joins the purging thread.
+  ~PoolPurger()
+  {
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+  }
+
+  PoolPurger(const PoolPurger &) = delete;
+  PoolPurger &operator=(const PoolPurger &) = delete;
+
+  /// Total number of bytes released to the OS so far.
+  size_t Released()
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_released;
+  }
+
+private:
+  void Run()
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    const auto tick = std::max(m_decay / 4, std::chrono::milliseconds(1));
+    size_t seen = 0u; // Dirty bytes at the last tick.
+    Clock::time_point since;
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    while (not m_wake.wait_for(guard, tick, [this] { return m_stop; }))
+    {
+      // Never hold both locks: the client may call Released() with the pool locked.
+      guard.unlock();
+
+      size_t released = 0u;
+      {
+        std::lock_guard<std::mutex> pool_guard(m_pool_lock);
+
+        size_t dirty = m_pool.DirtyBytes();
+        if (dirty != seen)
+        {
+          seen = dirty;
+          since = Clock::now();
+        }
+        else if (dirty > 0u and Clock::now() - since >= m_decay)
+        {
+          released = m_pool.Trim(m_advice);
+          seen = 0u;
+        }
+      }
+
+      guard.lock();
+      m_released += released;
+    }
+  }
+};
+} // namespace mp
+
+#endif
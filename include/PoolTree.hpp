@@ -0,0 +1,262 @@
+#include <stddef.h>
+#include <functional>
+#include <utility>
+#include "StoragePool.hpp"
+#include "NodeSlab.hpp"
+
+#ifndef POOL_TREE_H
+#define POOL_TREE_H
+
+namespace mp
+{
+/// Ordered map (AVL tree) whose nodes are clustered in slabs reserved from a StoragePool.
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class PoolTree
+{
+private:
+  struct Node
+  {
+    Node *m_left;
+    Node *m_right;
+    int m_height;
+    Key m_key;
+    Value m_value;
+
+    template <typename K, typename... Args>
+    explicit Node(K &&key, Args &&... args) : m_left(nullptr), m_right(nullptr), m_height(1), m_key(std::forward<K>(key)), m_value(std::forward<Args>(args)...)
+    { /* Empty */
+    }
+  };
+
+  NodeSlab<Node> m_nodes; //!< Node allocator.
+  Node *m_root;           //!< Root of the tree.
+  size_t m_size;          //!< Number of entries.
+  Compare m_less;
+
+public:
+  explicit PoolTree(StoragePool &pool) : m_nodes(pool), m_root(nullptr), m_size(0u)
+  { /* Empty */
+  }
+
+  ~PoolTree()
+  {
+    this->Clear();
+  }
+
+  PoolTree(const PoolTree &) = delete;
+  PoolTree &operator=(const PoolTree &) = delete;
+
+  size_t Size() const { return m_size; }
+  bool Empty() const { return m_size == 0u; }
+
+  /// Returns the value stored under `key`, or nullptr.
+  Value *Find(const Key &key)
+  {
+    Node *node = m_root;
+    while (node != nullptr)
+    {
+      if (m_less(key, node->m_key))
+        node = node->m_left;
+      else if (m_less(node->m_key, key))
+        node = node->m_right;
+      else
+        return &node->m_value;
+    }
+
+    return nullptr;
+  }
+
+  const Value *Find(const Key &key) const
+  {
+    return const_cast<PoolTree *>(this)->Find(key);
+  }
+
+  /// Inserts `key` with a value built from `args` unless it is already there; returns the stored value and whether it was inserted.
+  template <typename K, typename... Args>
+  std::pair<Value *, bool> Emplace(K &&key, Args &&... args)
+  {
+    std::pair<Value *, bool> result(nullptr, false);
+    m_root = this->Insert(m_root, result, std::forward<K>(key), std::forward<Args>(args)...);
+    m_size += result.second;
+
+    return result;
+  }
+
+  Value &operator[](const Key &key)
+  {
+    return *this->Emplace(key).first;
+  }
+
+  /// Removes `key`; returns whether it was there.
+  bool Erase(const Key &key)
+  {
+    bool erased = false;
+    m_root = this->Remove(m_root, key, erased);
+    m_size -= erased;
+
+    return erased;
+  }
+
+  /// Calls `fn(key, value)` for every entry, in key order.
+  template <typename Fn>
+  void ForEach(Fn fn)
+  {
+    this->Visit(m_root, fn);
+  }
+
+  void Clear()
+  {
+    this->Destroy(m_root);
+    m_root = nullptr;
+    m_size = 0u;
+  }
+
+  /// Height of the tree (0 when empty).
+  int Height() const
+  {
+    return Height(m_root);
+  }
+
+private:
+  static int Height(const Node *node)
+  {
+    return node == nullptr ? 0 : node->m_height;
+  }
+
+  static void Update(Node *node)
+  {
+    int left = Height(node->m_left), right = Height(node->m_right);
+    node->m_height = 1 + (left > right ? left : right);
+  }
+
+  static Node *RotateRight(Node *node)
+  {
+    Node *pivot = node->m_left;
+    node->m_left = pivot->m_right;
+    pivot->m_right = node;
+    Update(node);
+    Update(pivot);
+    return pivot;
+  }
+
+  static Node *RotateLeft(Node *node)
+  {
+    Node *pivot = node->m_right;
+    node->m_right = pivot->m_left;
+    pivot->m_left = node;
+    Update(node);
+    Update(pivot);
+    return pivot;
+  }
+
+  /// Restores the AVL invariant at `node`; returns the new root of the subtree.
+  static Node *Balance(Node *node)
+  {
+    Update(node);
+    int balance = Height(node->m_left) - Height(node->m_right);
+
+    if (balance > 1)
+    {
+      if (Height(node->m_left->m_left) < Height(node->m_left->m_right))
+        node->m_left = RotateLeft(node->m_left);
+      return RotateRight(node);
+    }
+    if (balance < -1)
+    {
+      if (Height(node->m_right->m_right) < Height(node->m_right->m_left))
+        node->m_right = RotateRight(node->m_right);
+      return RotateLeft(node);
+    }
+
+    return node;
+  }
+
+  template <typename K, typename... Args>
+  Node *Insert(Node *node, std::pair<Value *, bool> &result, K &&key, Args &&... args)
+  {
+    if (node == nullptr)
+    {
+      node = m_nodes.Create(std::forward<K>(key), std::forward<Args>(args)...);
+      result = std::make_pair(&node->m_value, true);
+      return node;
+    }
+
+    if (m_less(key, node->m_key))
+      node->m_left = this->Insert(node->m_left, result, std::forward<K>(key), std::forward<Args>(args)...);
+    else if (m_less(node->m_key, key))
+      node->m_right = this->Insert(node->m_right, result, std::forward<K>(key), std::forward<Args>(args)...);
+    else
+    {
+      result = std::make_pair(&node->m_value, false);
+      return node;
+    }
+
+    return Balance(node);
+  }
+
+  /// Unlinks the smallest node of the subtree into `min`; returns the new root of the subtree.
+  static Node *RemoveMin(Node *node, Node *&min)
+  {
+    if (node->m_left == nullptr)
+    {
+      min = node;
+      return node->m_right;
+    }
+
+    node->m_left = RemoveMin(node->m_left, min);
+    return Balance(node);
+  }
+
+  Node *Remove(Node *node, const Key &key, bool &erased)
+  {
+    if (node == nullptr)
+      return nullptr;
+
+    if (m_less(key, node->m_key))
+      node->m_left = this->Remove(node->m_left, key, erased);
+    else if (m_less(node->m_key, key))
+      node->m_right = this->Remove(node->m_right, key, erased);
+    else
+    {
+      Node *left = node->m_left, *right = node->m_right;
+      m_nodes.Destroy(node);
+      erased = true;
+
+      if (right == nullptr)
+        return left;
+
+      Node *successor = nullptr;
+      right = RemoveMin(right, successor);
+      successor->m_left = left;
+      successor->m_right = right;
+      return Balance(successor);
+    }
+
+    return Balance(node);
+  }
+
+  template <typename Fn>
+  static void Visit(Node *node, Fn &fn)
+  {
+    while (node != nullptr)
+    {
+      Visit(node->m_left, fn);
+      fn(node->m_key, node->m_value);
+      node = node->m_right;
+    }
+  }
+
+  void Destroy(Node *node)
+  {
+    while (node != nullptr)
+    {
+      this->Destroy(node->m_left);
+      Node *right = node->m_right;
+      m_nodes.Destroy(node);
+      node = right;
+    }
+  }
+};
+} // namespace mp
+
+#endif
@@ -0,0 +1,107 @@
+#include <stddef.h>
+#include <atomic>
+#include <new>
+#include <ostream>
+#include <thread>
+#include "StoragePool.hpp"
+#include "SLPool.hpp"
+
+#ifndef REMOTE_FREE_POOL_H
+#define REMOTE_FREE_POOL_H
+
+namespace mp
+{
+/// SLPool (or another POOL) owned by a single thread that any other thread may free into.
+/**
+ * Only the owner thread allocates and coalesces. A foreign thread that frees an area
+ * pushes it onto a lock-free stack with a single compare-and-swap (the link is
+ * written into the freed area itself); the owner takes the whole stack with one
+ * exchange and returns its areas to the free list at the start of its next
+ * Allocate(). Areas waiting on the stack are not available until then.
+ */
+template <size_t BLK_SIZE = 16, template <size_t> class POOL = SLPool>
+class RemoteFreePool : public StoragePool
+{
+private:
+  struct Node
+  {
+    Node *m_next;
+  };
+
+  POOL<BLK_SIZE> m_pool;         //!< The pool, touched only by the owner.
+  std::thread::id m_owner;       //!< Thread allowed to allocate and to free directly.
+  std::atomic<Node *> m_remote;  //!< Areas freed by other threads, newest first.
+
+public:
+  /// Constructor of RemoteFreePool; the calling thread becomes the owner.
+  explicit RemoteFreePool(size_t bytes) : m_pool(bytes),
+                                          m_owner(std::this_thread::get_id()),
+                                          m_remote(nullptr)
+  { /* Empty */
+  }
+
+  /// Destructs the RemoteFreePool (every other thread must be done with it).
+  ~RemoteFreePool()
+  {
+    this->Drain();
+  }
+
+  void *Allocate(size_t bytes)
+  {
+    this->Drain();
+    return m_pool.Allocate(bytes);
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &tag) noexcept
+  {
+    this->Drain();
+    return m_pool.Allocate(bytes, tag);
+  }
+
+  void Free(void *ptr)
+  {
+    if (std::this_thread::get_id() == m_owner)
+    {
+      m_pool.Free(ptr);
+      return;
+    }
+
+    Node *node = reinterpret_cast<Node *>(ptr);
+    node->m_next = m_remote.load(std::memory_order_relaxed);
+    while (not m_remote.compare_exchange_weak(node->m_next, node, std::memory_order_release, std::memory_order_relaxed))
+      ; // m_next was refreshed by the failed exchange.
+  }
+
+  /// Returns the areas freed by other threads to the free list; owner only. Returns how many there were.
+  size_t Drain()
+  {
+    if (m_remote.load(std::memory_order_relaxed) == nullptr)
+      return 0u;
+
+    size_t count = 0u;
+    for (Node *node = m_remote.exchange(nullptr, std::memory_order_acquire); node != nullptr; ++count)
+    {
+      Node *next = node->m_next;
+      m_pool.Free(node);
+      node = next;
+    }
+
+    return count;
+  }
+
+  /// Makes the calling thread the owner (e.g. after building the pool on another thread).
+  void Adopt()
+  {
+    m_owner = std::this_thread::get_id();
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream, const RemoteFreePool &obj)
+  {
+    stream << " RemoteFreePool { owner: " << obj.m_owner << " } " << std::endl;
+
+    return stream;
+  }
+};
+} // namespace mp
+
+#endif
@@ -1,4 +1,10 @@
 #include <stddef.h>
+#include <stdint.h>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "StoragePool.hpp"
 #include "mempool_common.h"
 
@@ -14,7 +20,7 @@ public:
   struct Header
   {
     size_t m_length;
-    Header() : m_length(0u){/* Empty */};
+    constexpr Header() : m_length(0u){/* Empty */};
   };
 
   struct Block : public Header
@@ -24,13 +30,17 @@ public:
       char m_raw[BLK_SIZE - sizeof(Header)]; // Client's raw area
     };
 
-    Block() : Header(), m_next(nullptr){/* Empty */};
+    constexpr Block() : Header(), m_next(nullptr){/* Empty */};
   };
 
 private:
   unsigned int m_n_blocks; //!< Number of blocks in the list.
   Block *m_pool;           //!< Head of list.
   Block &m_sentinel;       //!< End of the list.
+  bool m_owner;            //!< Whether m_pool was allocated by (and must be released by) the pool.
+  size_t m_dirty;          //!< Blocks freed since the last Trim().
+  Block *m_dirty_begin;    //!< First block freed since the last Trim().
+  Block *m_dirty_end;      //!< Past the last block freed since the last Trim() (and the header after it).
 
 public:
   static constexpr size_t BLK_SZ = sizeof(mp::SLPool<BLK_SIZE>::Block);     //!< The block size in bytes.
@@ -38,9 +48,51 @@ public:
   static constexpr size_t HEADER_SZ = sizeof(mp::SLPool<BLK_SIZE>::Header); //!< The header size in bytes.
 
   /// Constructor of SLPool, set the number of blocks, the sentinel and the memory pool.
-  explicit SLPool(size_t bytes) : m_n_blocks{(unsigned int)std::ceil((bytes + sizeof(Header)) / BLK_SIZE) + 1u},
+  explicit SLPool(size_t bytes) : m_n_blocks{(unsigned int)((bytes + HEADER_SZ + BLK_SZ - 1u) / BLK_SZ) + 1u},
                                   m_pool{new Block[m_n_blocks]},
-                                  m_sentinel{m_pool[m_n_blocks - 1]}
+                                  m_sentinel{m_pool[m_n_blocks - 1]},
+                                  m_owner{true},
+                                  m_dirty{0u},
+                                  m_dirty_begin{m_pool},
+                                  m_dirty_end{&m_sentinel}
+  {
+    this->Prime();
+  }
+
+  /// Constructor of SLPool over `bytes` bytes of caller-owned storage (at least two blocks long).
+  /**
+   * The storage is not released by the pool. Only the first and the last (sentinel)
+   * blocks are written, so untouched pages of a fresh mapping stay unbacked.
+   */
+  SLPool(void *storage, size_t bytes) : m_n_blocks{(unsigned int)(bytes / BLK_SZ)},
+                                        m_pool{reinterpret_cast<Block *>(storage)},
+                                        m_sentinel{m_pool[m_n_blocks - 1]},
+                                        m_owner{false},
+                                        m_dirty{0u},
+                                        m_dirty_begin{&m_sentinel},
+                                        m_dirty_end{m_pool}
+  {
+    this->Prime();
+  }
+
+protected:
+  struct Deferred
+  {
+  };
+
+  /// Constructor of SLPool over `n_blocks` blocks at `storage`, which are left untouched until Prime().
+  constexpr SLPool(Block *storage, unsigned int n_blocks, Deferred) : m_n_blocks{n_blocks},
+                                                                      m_pool{storage},
+                                                                      m_sentinel{storage[n_blocks - 1]},
+                                                                      m_owner{false},
+                                                                      m_dirty{0u},
+                                                                      m_dirty_begin{storage + (n_blocks - 1)},
+                                                                      m_dirty_end{storage}
+  { /* Empty */
+  }
+
+  /// Sets up the free list: a single area spanning the pool. Only the first block and the sentinel are written.
+  void Prime()
   {
     this->m_pool[0].m_length = (m_n_blocks - 1);
     this->m_pool[0].m_next = nullptr;
@@ -49,17 +101,31 @@ public:
     this->m_sentinel.m_length = 0;
   }
 
+public:
   /// Destructs the SLPool.
   ~SLPool()
   {
-    delete[] m_pool;
+    if (m_owner)
+      delete[] m_pool;
   }
 
+  SLPool(const SLPool &) = delete;
+  SLPool &operator=(const SLPool &) = delete;
+
   void *Allocate(size_t bytes)
+  {
+    void *ptr = this->Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+
+    return ptr;
+  }
+
+  void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
   {
     Block *fast = this->m_sentinel.m_next;
     Block *slow = &this->m_sentinel;
-    size_t blocks = std::ceil((bytes + HEADER_SZ) / BLK_SZ);
+    size_t blocks = (bytes + HEADER_SZ + BLK_SZ - 1u) / BLK_SZ;
 
     while (fast != nullptr)
     {
@@ -85,66 +151,163 @@ public:
       }
     }
 
-    throw std::bad_alloc();
+    return nullptr;
   }
 
   void Free(void *ptr)
   {
-    ptr = reinterpret_cast<Block *>(reinterpret_cast<Header *>(ptr) - (1U));
+    Block *current = reinterpret_cast<Block *>(reinterpret_cast<Header *>(ptr) - (1U));
+    this->m_dirty += current->m_length;
+    if (current < this->m_dirty_begin)
+      this->m_dirty_begin = current;
+    if (current + current->m_length + 1 > this->m_dirty_end)
+      this->m_dirty_end = current + current->m_length + 1;
 
-    Block *current = (Block *)ptr;
-    Block *fast = this->m_sentinel.m_next;
-    Block *slow = &this->m_sentinel;
+    // The free list is kept in address order: find the free areas around `current`.
+    Block *pre = &this->m_sentinel;
+    Block *pos = this->m_sentinel.m_next;
 
-    if(fast == nullptr) 
+    while (pos != nullptr and pos < current)
     {
-      slow->m_next = current;
-      fast = current;
+      pre = pos;
+      pos = pos->m_next;
     }
 
-    while (fast != nullptr)
+    // Merge with the free area on the right...
+    if (pos != nullptr and current + current->m_length == pos)
     {
-      if ((current - fast) < (current - slow) and (current - fast) > 0)
-      {
-        slow = fast;
-        fast = fast->m_next;
-      }
-      else
-          break;
+      current->m_length = current->m_length + pos->m_length;
+      current->m_next = pos->m_next;
     }
-    
-    Block *pre = fast;
-    Block *pos = fast->m_next;
+    else
+      current->m_next = pos;
 
-    if ((current - pre) == (long int)pre->m_length and (pos - current) == (long int)current->m_length)
-    {
-      pre->m_next = pos->m_next;
-      pre->m_length = pre->m_length + current->m_length + pos->m_length;
-    }
-    else if ((current - pre) == (long int)pre->m_length)
+    // ... and with the one on the left (the sentinel is never merged).
+    if (pre != &this->m_sentinel and pre + pre->m_length == current)
     {
-      pre->m_next = pos;
       pre->m_length = pre->m_length + current->m_length;
+      pre->m_next = current->m_next;
     }
-    else if ((pos - current) == (long int)current->m_length)
-    {
+    else
       pre->m_next = current;
-      current->m_next = pos->m_next;
-      current->m_length = current->m_length + pos->m_length;
+  }
+
+  /// Gives the pages inside free areas back to the OS, returning how many bytes were released.
+  /**
+   * Only whole pages past the first block of each free area are released, so every
+   * header of the free list stays resident. Released pages read back as zeros (or,
+   * with MADV_FREE, as their old contents until the kernel reclaims them) and are
+   * faulted in again when the area is reused.
+   *
+   * Only the span freed since the last Trim() is visited, and within it only the
+   * pages still resident (as mincore() tells) are released and counted: a page is
+   * not counted twice unless it was written in between. MADV_FREE leaves the pages
+   * resident until the kernel needs them, so those may be counted again when the
+   * area around them is freed again before that.
+   */
+  size_t Trim(int advice = MADV_DONTNEED)
+  {
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t first = reinterpret_cast<uintptr_t>(this->m_dirty_begin) & ~(page - 1u);
+    const uintptr_t last = (reinterpret_cast<uintptr_t>(this->m_dirty_end) + page - 1u) & ~(page - 1u);
+    size_t released = 0u;
+
+    for (Block *area = this->m_sentinel.m_next; area != nullptr and reinterpret_cast<uintptr_t>(area) < last; area = area->m_next)
+    {
+      uintptr_t begin = (reinterpret_cast<uintptr_t>(area + 1U) + page - 1u) & ~(page - 1u);
+      uintptr_t end = reinterpret_cast<uintptr_t>(area + area->m_length) & ~(page - 1u);
+
+      begin = begin < first ? first : begin;
+      end = end > last ? last : end;
+      if (end > begin)
+        released += Release(begin, end, page, advice);
     }
-    else
+
+    this->m_dirty = 0u;
+    this->m_dirty_begin = &this->m_sentinel;
+    this->m_dirty_end = this->m_pool;
+    return released;
+  }
+
+  /// Number of bytes freed since the last Trim() (an upper bound on what a Trim() may release).
+  size_t DirtyBytes() const
+  {
+    return this->m_dirty * BLK_SZ;
+  }
+
+  /// Calls `fn(area, bytes)` for every free area of the list, in address order.
+  template <typename Fn>
+  void ForEachFree(Fn fn) const
+  {
+    for (const Block *area = this->m_sentinel.m_next; area != nullptr; area = area->m_next)
+      fn(static_cast<const void *>(area), area->m_length * BLK_SZ);
+  }
+
+  /// Calls `fn(area, bytes, free)` for every area of the pool, reserved or free, in address order.
+  /**
+   * Areas tile the pool, so the walk hops from header to header and merges in the
+   * (address-ordered) free list as it goes: it allocates nothing and touches one
+   * header per area. The pool must not change during the walk.
+   */
+  template <typename Fn>
+  void Walk(Fn fn) const
+  {
+    const Block *next_free = this->m_sentinel.m_next;
+    for (const Block *area = this->m_pool; area < &this->m_sentinel and area->m_length > 0u; area += area->m_length)
     {
-      current->m_next = pre->m_next;
-      pre->m_next = current;
+      bool free = area == next_free;
+      if (free)
+        next_free = next_free->m_next;
+      fn(static_cast<const void *>(area), area->m_length * BLK_SZ, free);
     }
   }
 
+  /// Number of bytes the client may use in the area returned by Allocate().
+  static size_t UsableSize(const void *ptr)
+  {
+    return reinterpret_cast<const Header *>(ptr)[-1].m_length * BLK_SZ - HEADER_SZ;
+  }
+
   friend std::ostream &operator<<(std::ostream &stream, const SLPool &obj)
   {
-    stream << " SLPool { blocks: " << obj.m_n_blocks << " } " << std::endl;
+    size_t n_free = 0u, free_bytes = 0u, largest = 0u;
+    obj.ForEachFree([&](const void *, size_t bytes) {
+      ++n_free;
+      free_bytes += bytes;
+      largest = bytes > largest ? bytes : largest;
+    });
+
+    stream << " SLPool { blocks: " << obj.m_n_blocks << ", free areas: " << n_free << ", free bytes: " << free_bytes
+           << ", largest free area: " << largest << " } " << std::endl;
 
     return stream;
   }
+
+private:
+  /// Applies `advice` to the resident pages of [begin, end), returning how many bytes those were.
+  static size_t Release(uintptr_t begin, uintptr_t end, uintptr_t page, int advice)
+  {
+    unsigned char resident[512]; // One byte per page.
+    size_t released = 0u;
+
+    for (uintptr_t chunk = begin; chunk < end; chunk += sizeof(resident) * page)
+    {
+      size_t n_pages = (end - chunk) / page < sizeof(resident) ? (end - chunk) / page : sizeof(resident);
+      if (mincore(reinterpret_cast<void *>(chunk), n_pages * page, resident) != 0)
+        std::memset(resident, 1, n_pages);
+
+      // One call per run of resident pages.
+      for (size_t i = 0u, j; i < n_pages; i = j)
+      {
+        for (j = i; j < n_pages and (resident[j] & 1u) == (resident[i] & 1u); ++j)
+          ;
+        if ((resident[i] & 1u) and madvise(reinterpret_cast<void *>(chunk + i * page), (j - i) * page, advice) == 0)
+          released += (j - i) * page;
+      }
+    }
+
+    return released;
+  }
 };
 } // namespace mp
 
@@ -0,0 +1,79 @@
+#include <stddef.h>
+#include <atomic>
+#include <cassert>
+#include <new>
+#include "SLPool.hpp"
+
+#ifndef STATIC_SLPOOL_H
+#define STATIC_SLPOOL_H
+
+namespace mp
+{
+/// SLPool whose `BYTES` bytes of storage are a static, zero-initialized buffer.
+/**
+ * The constructor is constexpr, so a StaticSLPool with static storage duration is
+ * constant-initialized: it is ready before any dynamic initializer runs (no
+ * initialization-order issues) and never touches the heap. The free list is only
+ * set up by the first allocation, writing just the first block and the sentinel.
+ *
+ * The blocks are not part of the object: they are a static member, which lands in
+ * .bss (no room in the executable, no pages until they are used), while the object
+ * itself is a few words. There is thus one buffer per type, and `TAG` (any type,
+ * typically a struct declared in place) names it: each pool needs a TAG of its own.
+ * The first pool of a type to allocate claims the buffer until it is destroyed;
+ * another pool of that type allocating meanwhile is a bug, caught by an assertion
+ * (and failing to allocate when assertions are off).
+ */
+template <size_t BLK_SIZE, size_t BYTES, typename TAG>
+class StaticSLPool : public SLPool<BLK_SIZE>
+{
+public:
+  typedef typename SLPool<BLK_SIZE>::Block Block;
+
+  static constexpr size_t N_BLOCKS = (BYTES + SLPool<BLK_SIZE>::HEADER_SZ + SLPool<BLK_SIZE>::BLK_SZ - 1u) / SLPool<BLK_SIZE>::BLK_SZ + 1u; //!< Blocks in the pool, sentinel included.
+
+private:
+  alignas(alignof(max_align_t)) static Block s_storage[N_BLOCKS]; //!< The pool itself.
+  static std::atomic<StaticSLPool *> s_owner;                      //!< Pool whose free list is in s_storage.
+
+public:
+  /// Constructor of StaticSLPool, binds the pool to the storage of its type.
+  constexpr StaticSLPool() : SLPool<BLK_SIZE>(s_storage, N_BLOCKS, typename SLPool<BLK_SIZE>::Deferred())
+  { /* Empty */
+  }
+
+  /// Destructs the StaticSLPool, handing the storage over to the next pool of its type.
+  ~StaticSLPool()
+  {
+    StaticSLPool *self = this;
+    s_owner.compare_exchange_strong(self, nullptr, std::memory_order_release, std::memory_order_relaxed);
+  }
+
+  using SLPool<BLK_SIZE>::Allocate;
+
+  void *Allocate(size_t bytes, const std::nothrow_t &tag) noexcept
+  {
+    if (s_owner.load(std::memory_order_acquire) != this)
+    {
+      StaticSLPool *owner = nullptr;
+      if (not s_owner.compare_exchange_strong(owner, this, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        assert(not "another StaticSLPool of this type owns the storage: give each pool its own TAG");
+        return nullptr;
+      }
+
+      this->Prime();
+    }
+
+    return SLPool<BLK_SIZE>::Allocate(bytes, tag);
+  }
+};
+
+template <size_t BLK_SIZE, size_t BYTES, typename TAG>
+alignas(alignof(max_align_t)) typename StaticSLPool<BLK_SIZE, BYTES, TAG>::Block StaticSLPool<BLK_SIZE, BYTES, TAG>::s_storage[N_BLOCKS];
+
+template <size_t BLK_SIZE, size_t BYTES, typename TAG>
+std::atomic<StaticSLPool<BLK_SIZE, BYTES, TAG> *> StaticSLPool<BLK_SIZE, BYTES, TAG>::s_owner{nullptr};
+} // namespace mp
+
+#endif
@@ -1,4 +1,5 @@
 #include <stddef.h>
+#include <new>
 #ifndef STORAGE_POOL_H
 #define STORAGE_POOL_H
 
@@ -10,6 +11,19 @@ public:
   //virtual ~StoragePool() = 0;
   virtual void *Allocate(size_t) = 0;
   virtual void Free(void *) = 0;
+
+  /// Same as Allocate(), but returns nullptr instead of throwing when the request can't be served.
+  virtual void *Allocate(size_t bytes, const std::nothrow_t &) noexcept
+  {
+    try
+    {
+      return Allocate(bytes);
+    }
+    catch (const std::bad_alloc &)
+    {
+      return nullptr;
+    }
+  }
 };
 } // namespace mp
 
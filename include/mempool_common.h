@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <new>
 #include "StoragePool.hpp"
 
 using namespace mp;
@@ -12,39 +13,221 @@ struct Tag
 {
   StoragePool *pool;
 };
+
+/// Tag in front of the area at `ptr`.
+/**
+ * The compiler takes the global new/delete below (or malloc, when they are
+ * replaced) for the standard ones and follows the pointers they pass around, so
+ * the Tag (just before the object it knows of) looks out of bounds, and a pool area
+ * looks like a non-heap object given to delete. The empty asm hides where the
+ * pointer comes from; it costs nothing.
+ */
+inline __attribute__((always_inline)) Tag *TagOf(void *ptr) noexcept
+{
+  asm("" : "+r"(ptr));
+  return reinterpret_cast<Tag *>(ptr) - 1U;
+}
+
+/// Area behind `tag` (the converse of TagOf()).
+inline __attribute__((always_inline)) void *AreaOf(Tag *tag) noexcept
+{
+  void *ptr = tag + 1U;
+  asm("" : "+r"(ptr));
+  return ptr;
+}
 } //namespace mp
 
+// Code that provides its own allocator (e.g. the malloc interposition library)
+// defines MP_NO_GLOBAL_NEW to keep just the Tag and skip the operators below.
+#ifndef MP_NO_GLOBAL_NEW
+
+#ifdef MP_HEAP_PROFILER
+#include <stdint.h>
+#include "HeapProfiler.hpp"
+
+namespace mp
+{
+// A sampled area has the lowest bit of its Tag's pool pointer set.
+inline __attribute__((always_inline)) void SampleTag(Tag *tag, size_t bytes)
+{
+  if (HeapProfiler::ShouldSample(bytes) and HeapProfiler::Record(tag + 1U, bytes))
+    tag->pool = reinterpret_cast<StoragePool *>(reinterpret_cast<uintptr_t>(tag->pool) | 1u);
+}
+
+inline __attribute__((always_inline)) void UnsampleTag(Tag *tag)
+{
+  uintptr_t pool = reinterpret_cast<uintptr_t>(tag->pool);
+  if (pool & 1u)
+  {
+    HeapProfiler::Forget(tag + 1U);
+    tag->pool = reinterpret_cast<StoragePool *>(pool & ~uintptr_t(1u));
+  }
+}
+} // namespace mp
+
+#define MP_SAMPLE_TAG(tag, bytes) mp::SampleTag(tag, bytes)
+#define MP_UNSAMPLE_TAG(tag) mp::UnsampleTag(tag)
+#else
+#define MP_SAMPLE_TAG(tag, bytes)
+#define MP_UNSAMPLE_TAG(tag)
+#endif
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define MP_HAS_PMR 1
+#endif
+#endif
+
+namespace mp
+{
+/// Pool that plain new/new[] on this thread are served from (nullptr: the default heap).
+inline StoragePool *&CurrentPool() noexcept
+{
+  static thread_local StoragePool *current = nullptr;
+  return current;
+}
+
+#ifdef MP_HAS_PMR
+/// memory_resource over plain new: the pool of the innermost PoolScope, or the heap.
+class ScopedResource : public std::pmr::memory_resource
+{
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override
+  {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator new(bytes, std::align_val_t(alignment));
+    return ::operator new(bytes);
+  }
+
+  void do_deallocate(void *ptr, size_t, size_t alignment) override
+  {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      ::operator delete(ptr, std::align_val_t(alignment));
+    else
+      ::operator delete(ptr);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+/// Makes a ScopedResource the pmr default resource, unless the program already set its own.
+inline void InstallScopedResource() noexcept
+{
+  // Never destroyed: containers in other static objects may still use it at exit.
+  alignas(ScopedResource) static char storage[sizeof(ScopedResource)];
+  static const bool installed = std::pmr::get_default_resource() == std::pmr::new_delete_resource() and
+                                std::pmr::set_default_resource(new (storage) ScopedResource) != nullptr;
+  (void)installed;
+}
+#endif
+
+/// Serves plain new/new[] on this thread from `pool` for as long as the scope lives.
+/**
+ * Scopes nest, the innermost one wins. The Tag of each area records its pool, so
+ * areas may be deleted after the scope is gone; the pool must outlive them, and
+ * must be safe to use from every thread that deletes them. In C++17 the first
+ * scope also routes the pmr default resource through plain new (see ScopedResource).
+ */
+class PoolScope
+{
+private:
+  StoragePool *m_previous; //!< Pool of the enclosing scope, restored on exit.
+
+public:
+  explicit PoolScope(StoragePool &pool) : m_previous(CurrentPool())
+  {
+#ifdef MP_HAS_PMR
+    InstallScopedResource();
+#endif
+    CurrentPool() = &pool;
+  }
+
+  ~PoolScope()
+  {
+    CurrentPool() = m_previous;
+  }
+
+  PoolScope(const PoolScope &) = delete;
+  PoolScope &operator=(const PoolScope &) = delete;
+};
+} // namespace mp
+
 void *operator new[](size_t bytes, StoragePool &p)
 {
   Tag *const tag = reinterpret_cast<Tag *>(p.Allocate(bytes + sizeof(Tag)));
   tag->pool = &p;
+  MP_SAMPLE_TAG(tag, bytes);
 
   // skip sizeof tag to get the raw data-block.
-  return (reinterpret_cast<void *>(tag + 1U));
+  return mp::AreaOf(tag);
 }
 
 void *operator new(size_t bytes, StoragePool &p)
 {
   Tag *const tag = reinterpret_cast<Tag *>(p.Allocate(bytes + sizeof(Tag)));
   tag->pool = &p;
+  MP_SAMPLE_TAG(tag, bytes);
+
+  return mp::AreaOf(tag);
+}
 
-  return (reinterpret_cast<void *>(tag + 1U));
+void *operator new(size_t bytes, StoragePool &p, const std::nothrow_t &tag) noexcept
+{
+  Tag *const area = reinterpret_cast<Tag *>(p.Allocate(bytes + sizeof(Tag), tag));
+  if (area == nullptr)
+    return nullptr;
+  area->pool = &p;
+  MP_SAMPLE_TAG(area, bytes);
+
+  return mp::AreaOf(area);
+}
+
+// Reserves `bytes` from the current pool of this thread. The current pool is cleared
+// during the call, so a pool that allocates for itself does not recurse into itself.
+static void *NewInCurrentPool(size_t bytes)
+{
+  StoragePool *&current = mp::CurrentPool();
+  StoragePool *const pool = current;
+  current = nullptr;
+  try
+  {
+    void *ptr = ::operator new(bytes, *pool);
+    current = pool;
+    return ptr;
+  }
+  catch (...)
+  {
+    current = pool;
+    throw;
+  }
 }
 
 void *operator new(size_t bytes)
 {
+  if (mp::CurrentPool() != nullptr)
+    return NewInCurrentPool(bytes);
+
   Tag *const tag = reinterpret_cast<Tag *>(std::malloc(bytes + sizeof(Tag)));
   tag->pool = nullptr;
+  MP_SAMPLE_TAG(tag, bytes);
 
-  return (reinterpret_cast<void *>(tag + 1U));
+  return mp::AreaOf(tag);
 }
 
 void *operator new[](size_t bytes)
 {
+  if (mp::CurrentPool() != nullptr)
+    return NewInCurrentPool(bytes);
+
   Tag *const tag = reinterpret_cast<Tag *>(std::malloc(bytes + sizeof(Tag)));
   tag->pool = nullptr;
+  MP_SAMPLE_TAG(tag, bytes);
 
-  return (reinterpret_cast<void *>(tag + 1U));
+  return mp::AreaOf(tag);
 }
 
 void operator delete(void *arg) noexcept
@@ -52,7 +235,8 @@ void operator delete(void *arg) noexcept
   // We need subtract 1U (in fact, pointer arithmetics) because arg
   // points to the raw data (second block of information).
   // The pool id (tag) is located 'sizeof(Tag)' bytes before.
-  Tag *const tag = reinterpret_cast<Tag *>(arg) - 1U;
+  Tag *const tag = mp::TagOf(arg);
+  MP_UNSAMPLE_TAG(tag);
   if (nullptr != tag->pool) // Memory block belongs to a particular GM.
     tag->pool->Free(tag);
   else
@@ -61,11 +245,14 @@ void operator delete(void *arg) noexcept
 
 void operator delete[](void *arg) noexcept
 {
-  Tag *const tag = reinterpret_cast<Tag *>(arg) - 1U;
+  Tag *const tag = mp::TagOf(arg);
+  MP_UNSAMPLE_TAG(tag);
   if (nullptr != tag->pool)
     tag->pool->Free(tag);
   else
     std::free(tag);
 }
 
+#endif // MP_NO_GLOBAL_NEW
+
 #endif
\ No newline at end of file
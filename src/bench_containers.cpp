@@ -0,0 +1,127 @@
+/**
+ * @file bench_containers.cpp
+ *
+ * @description
+ * Iteration and lookup: pool containers vs. std::list / std::unordered_map / std::map.
+ *
+ * The containers are filled while the program keeps allocating other objects of
+ * assorted sizes, as real programs do, so nodes from the default heap end up
+ * scattered while pool nodes stay clustered in their slabs.
+ *
+ * Usage: bench_containers [elements]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/PoolList.hpp"
+#include "../include/PoolHashMap.hpp"
+#include "../include/PoolTree.hpp"
+
+using namespace mp;
+
+/// Allocates an unrelated object of random size (kept alive until the end).
+struct Noise
+{
+    std::mt19937 m_g{7};
+    std::vector<char *> m_objects;
+
+    void operator()()
+    {
+        m_objects.push_back(new char[16 + m_g() % 112]);
+    }
+
+    ~Noise()
+    {
+        for (auto object : m_objects)
+            delete[] object;
+    }
+};
+
+/// Runs `body` `rounds` times; returns nanoseconds per element.
+template <typename Body>
+double measure(size_t elements, size_t rounds, Body body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+        body();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (rounds * elements);
+}
+
+volatile long sink;
+
+void report(const char *what, double standard, double pool)
+{
+    std::cout << ">>> " << std::left << std::setw(28) << what << std::right << std::setw(10) << standard << std::setw(10) << pool
+              << std::setw(9) << standard / pool << "x" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    const size_t rounds(10);
+    SLPool<16> p(n * 160);
+    Noise noise;
+
+    std::vector<int> keys(n);
+    std::mt19937 g(2018);
+    for (auto &key : keys)
+        key = int(g());
+    std::vector<int> probes(keys);
+    std::shuffle(probes.begin(), probes.end(), g);
+
+    std::list<int> std_list;
+    PoolList<int> pool_list(p);
+    std::unordered_map<int, int> std_hash;
+    PoolHashMap<int, int> pool_hash(p);
+    std::map<int, int> std_tree;
+    PoolTree<int, int> pool_tree(p);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        std_list.push_back(keys[i]);
+        pool_list.PushBack(keys[i]);
+        std_hash[keys[i]] = int(i);
+        pool_hash[keys[i]] = int(i);
+        std_tree[keys[i]] = int(i);
+        pool_tree[keys[i]] = int(i);
+        noise();
+    }
+
+    std::cout << ">>> " << n << " elements (ns per element)\n\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << ">>>                               std      pool  speedup" << std::endl;
+
+    report("list iteration",
+           measure(n, rounds, [&] { long s = 0; for (int v : std_list) s += v; sink = s; }),
+           measure(n, rounds, [&] { long s = 0; for (int v : pool_list) s += v; sink = s; }));
+
+    report("hash map lookup",
+           measure(n, rounds, [&] { long s = 0; for (int k : probes) s += std_hash.find(k)->second; sink = s; }),
+           measure(n, rounds, [&] { long s = 0; for (int k : probes) s += *pool_hash.Find(k); sink = s; }));
+
+    report("hash map iteration",
+           measure(n, rounds, [&] { long s = 0; for (auto &e : std_hash) s += e.second; sink = s; }),
+           measure(n, rounds, [&] { long s = 0; pool_hash.ForEach([&s](int, int v) { s += v; }); sink = s; }));
+
+    report("tree lookup",
+           measure(n, rounds, [&] { long s = 0; for (int k : probes) s += std_tree.find(k)->second; sink = s; }),
+           measure(n, rounds, [&] { long s = 0; for (int k : probes) s += *pool_tree.Find(k); sink = s; }));
+
+    report("tree iteration",
+           measure(n, rounds, [&] { long s = 0; for (auto &e : std_tree) s += e.second; sink = s; }),
+           measure(n, rounds, [&] { long s = 0; pool_tree.ForEach([&s](int, int v) { s += v; }); sink = s; }));
+
+    return EXIT_SUCCESS;
+}
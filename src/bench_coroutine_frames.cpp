@@ -0,0 +1,213 @@
+/**
+ * @file bench_coroutine_frames.cpp
+ *
+ * @description
+ * Cost of coroutine frame allocation: default heap vs. GREMLINS pools (C++20).
+ *
+ * Runs the same lazy task chain and generator loop three times: with frames from
+ * the default heap, from the thread's FramePool() and from a fixed-block
+ * BitmapPool passed to each coroutine.
+ *
+ * Usage: bench_coroutine_frames [coroutines]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <utility>
+
+#include "../include/mempool_common.h"
+#include "../include/BitmapPool.hpp"
+#include "../include/PoolPromise.hpp"
+
+using namespace mp;
+
+/// Promise base with no allocation functions: frames come from the global operator new.
+struct HeapPromise
+{
+};
+
+/// Lazy task: starts when awaited, resumes its awaiter when done.
+template <typename Base>
+class Task
+{
+public:
+    struct promise_type : Base
+    {
+        long m_value = 0;
+        std::coroutine_handle<> m_awaiter;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        void return_value(long value) { m_value = value; }
+        void unhandled_exception() { std::terminate(); }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept
+            {
+                auto awaiter = self.promise().m_awaiter;
+                return awaiter ? awaiter : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+    Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+    {
+        m_handle.promise().m_awaiter = awaiter;
+        return m_handle;
+    }
+    long await_resume() { return m_handle.promise().m_value; }
+
+    /// Runs a top-level task to completion.
+    long Get()
+    {
+        m_handle.resume();
+        return m_handle.promise().m_value;
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/// Generator of longs.
+template <typename Base>
+class Generator
+{
+public:
+    struct promise_type : Base
+    {
+        long m_value = 0;
+
+        Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(long value)
+        {
+            m_value = value;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Generator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+    Generator(Generator &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    ~Generator()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool Next()
+    {
+        m_handle.resume();
+        return not m_handle.done();
+    }
+    long Value() const { return m_handle.promise().m_value; }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// Frames from the default heap or from FramePool(), depending on the promise base.
+template <typename Base>
+Task<Base> leaf(long i)
+{
+    co_return i * 2;
+}
+
+template <typename Base>
+Task<Base> parent(long i)
+{
+    long a = co_await leaf<Base>(i);
+    long b = co_await leaf<Base>(i + 1);
+    co_return a + b;
+}
+
+template <typename Base>
+Generator<Base> count(long n)
+{
+    for (long i = 0; i < n; ++i)
+        co_yield i;
+}
+
+// Frames from an explicit pool (the allocator-passing form).
+Task<PoolPromise> leaf(StoragePool &, long i)
+{
+    co_return i * 2;
+}
+
+Task<PoolPromise> parent(StoragePool &pool, long i)
+{
+    long a = co_await leaf(pool, i);
+    long b = co_await leaf(pool, i + 1);
+    co_return a + b;
+}
+
+Generator<PoolPromise> count(StoragePool &, long n)
+{
+    for (long i = 0; i < n; ++i)
+        co_yield i;
+}
+
+/// Runs `body` `n` times; returns nanoseconds per run and stores the checksum.
+template <typename Body>
+double measure(size_t n, long &checksum, Body body)
+{
+    checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i)
+        checksum += body(long(i));
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / n;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    BitmapPool<256> slots(256 * 64);
+    long sums[3][2];
+    double cost[3][2];
+
+    auto drain = [](auto generator) {
+        long sum = 0;
+        while (generator.Next())
+            sum += generator.Value();
+        return sum;
+    };
+
+    cost[0][0] = measure(n, sums[0][0], [](long i) { return parent<HeapPromise>(i).Get(); });
+    cost[1][0] = measure(n, sums[1][0], [](long i) { return parent<PoolPromise>(i).Get(); });
+    cost[2][0] = measure(n, sums[2][0], [&slots](long i) { return parent(slots, i).Get(); });
+
+    cost[0][1] = measure(n, sums[0][1], [&drain](long) { return drain(count<HeapPromise>(4)); });
+    cost[1][1] = measure(n, sums[1][1], [&drain](long) { return drain(count<PoolPromise>(4)); });
+    cost[2][1] = measure(n, sums[2][1], [&drain, &slots](long) { return drain(count(slots, 4)); });
+
+    const char *names[3] = {"default heap          ", "thread FramePool()    ", "BitmapPool<256> passed"};
+
+    std::cout << ">>> Coroutine frames, " << n << " runs (ns per run: 3 frames per task chain, 1 per generator)\n\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << ">>>                        task chain   generator" << std::endl;
+    for (int i = 0; i < 3; ++i)
+        std::cout << ">>> " << names[i] << std::setw(12) << cost[i][0] << std::setw(12) << cost[i][1] << std::endl;
+
+    bool consistent = sums[0][0] == sums[1][0] and sums[0][0] == sums[2][0] and sums[0][1] == sums[1][1] and sums[0][1] == sums[2][1];
+    return consistent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
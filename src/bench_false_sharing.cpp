@@ -0,0 +1,75 @@
+/**
+ * @file bench_false_sharing.cpp
+ *
+ * @description
+ * False sharing between areas of the same pool handed to different threads.
+ *
+ * One small counter per thread is reserved, back to back, from the pool; then every
+ * thread increments its own counter. With the packed SLPool<16> layout several
+ * counters (and their neighbours' Header and Tag) share a cache line, which bounces
+ * between the cores; with CacheAlignedPool each counter has its lines to itself.
+ *
+ * Usage: bench_false_sharing [threads] [increments per thread]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/CacheAlignedPool.hpp"
+
+using namespace mp;
+
+struct Counter
+{
+    std::atomic<long> m_value{0};
+};
+
+/// Milliseconds taken by `n_threads` threads to increment `n` times counters reserved from `pool`.
+double measure(StoragePool &pool, unsigned n_threads, long n)
+{
+    std::vector<Counter *> counters;
+    for (unsigned t = 0; t < n_threads; ++t)
+        counters.push_back(new (pool) Counter);
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < n_threads; ++t)
+        threads.emplace_back([&counters, t, n] {
+            for (long i = 0; i < n; ++i)
+                counters[t]->m_value.fetch_add(1, std::memory_order_relaxed);
+        });
+    for (auto &thread : threads)
+        thread.join();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (auto counter : counters)
+        delete counter;
+
+    return elapsed.count();
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned n_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    long n = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 20000000;
+
+    SLPool<16> packed(1u << 16);
+    CacheAlignedPool<64> lines(1u << 16, CacheAlignedPool<64>::WHOLE_LINES);
+    CacheAlignedPool<64> data(1u << 16, CacheAlignedPool<64>::DATA_ON_LINE);
+
+    std::cout << ">>> " << n_threads << " threads, " << n << " increments each (" << std::thread::hardware_concurrency()
+              << " hardware threads)\n\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << ">>> SLPool<16>                       " << std::setw(10) << measure(packed, n_threads, n) << " ms" << std::endl;
+    std::cout << ">>> CacheAlignedPool<64> whole lines " << std::setw(10) << measure(lines, n_threads, n) << " ms" << std::endl;
+    std::cout << ">>> CacheAlignedPool<64> data on line" << std::setw(10) << measure(data, n_threads, n) << " ms" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file bench_free_index.cpp
+ *
+ * @description
+ * Scaling of Allocate/Free with the number of free areas: SLPool (address-ordered
+ * singly linked list) vs. IndexedPool (size and address treaps).
+ *
+ * The pool is fragmented into `n` small holes, each between two reserved areas, with
+ * the rest of the pool as one large free area at the end. Two operations are timed:
+ *
+ *  - tail: reserve and free an area too large for any hole, so the list has to be
+ *    walked to its end, and then walked again to free the area;
+ *  - hole: free a random reserved area (which merges with the holes around it) and
+ *    reserve it again.
+ *
+ * Then the holes are spaced a fixed number of blocks apart, Fibonacci numbers and
+ * round numbers close to them, and IndexedPool runs the hole workload again. Its
+ * treaps must stay balanced whatever the spacing.
+ *
+ * Usage: bench_free_index [largest number of holes]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/IndexedPool.hpp"
+
+using namespace mp;
+
+const size_t HOLE = 32;  //!< Bytes of the small areas.
+const size_t LARGE = 256; //!< Bytes of an area that fits no hole.
+
+/// Returns nanoseconds per operation of both workloads on a pool with `n` holes.
+template <typename Pool>
+std::pair<double, double> measure(size_t n, size_t rounds)
+{
+    Pool pool(2 * n * 64 + (1u << 20));
+    std::vector<void *> areas(2 * n);
+    for (auto &area : areas)
+        area = pool.Allocate(HOLE);
+    for (size_t i = 0; i < areas.size(); i += 2)
+        pool.Free(areas[i]);
+
+    std::mt19937 g(2018);
+    std::chrono::duration<double, std::nano> tail(0), hole(0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+        pool.Free(pool.Allocate(LARGE));
+    tail = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        void *&area = areas[2 * (g() % n) + 1];
+        pool.Free(area);
+        area = pool.Allocate(HOLE);
+    }
+    hole = std::chrono::steady_clock::now() - start;
+
+    return std::make_pair(tail.count() / rounds, hole.count() / rounds);
+}
+
+/// Nanoseconds per hole operation on an IndexedPool with `n` holes, `stride` blocks apart.
+double measure_stride(size_t n, size_t stride, size_t rounds)
+{
+    using Pool = IndexedPool<16>;
+    const size_t spacer((stride - Pool::MIN_BLOCKS) * Pool::BLK_SZ - Pool::HEADER_SZ);
+
+    Pool pool((n + 1) * stride * Pool::BLK_SZ);
+    std::vector<void *> areas(2 * n);
+    for (size_t i = 0; i < areas.size(); ++i)
+        areas[i] = pool.Allocate(i % 2 == 0 ? HOLE : spacer);
+    for (size_t i = 0; i < areas.size(); i += 2)
+        pool.Free(areas[i]);
+
+    std::mt19937 g(2018);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        void *&area = areas[2 * (g() % n) + 1];
+        pool.Free(area);
+        area = pool.Allocate(spacer);
+    }
+    std::chrono::duration<double, std::nano> hole = std::chrono::steady_clock::now() - start;
+
+    return hole.count() / rounds;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t largest = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 65536;
+    const size_t rounds(2000);
+
+    std::cout << ">>> ns per operation (Allocate + Free)\n\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << ">>>    holes   tail: SLPool  IndexedPool   hole: SLPool  IndexedPool" << std::endl;
+
+    for (size_t n = 256; n <= largest; n *= 4)
+    {
+        auto list = measure<SLPool<16>>(n, rounds);
+        auto index = measure<IndexedPool<16>>(n, rounds);
+        std::cout << ">>> " << std::setw(8) << n << std::setw(15) << list.first << std::setw(13) << index.first
+                  << std::setw(15) << list.second << std::setw(13) << index.second << std::endl;
+    }
+
+    const size_t n(std::min<size_t>(largest, 18000));
+    std::cout << "\n>>> IndexedPool, " << n << " holes spaced by\n\n";
+    std::cout << ">>>   blocks   hole" << std::endl;
+    for (size_t stride : {987, 1000, 1597, 1600, 2584, 2600})
+        std::cout << ">>> " << std::setw(8) << stride << std::setw(13) << measure_stride(n, stride, rounds) << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file bench_heap_profiler.cpp
+ *
+ * @description
+ * Cost of the sampling heap profiler (built with MP_HEAP_PROFILER): time of a
+ * new/delete pair with sampling off, and at the default rate.
+ *
+ * Runs alternate between both settings, so that drifts in clock speed or load hit
+ * both sides alike, and the medians are reported.
+ *
+ * Usage: bench_heap_profiler [runs]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../include/mempool_common.h"
+
+using namespace mp;
+
+const size_t area_len(64);
+
+/// Mean cost of a new/delete pair, in nanoseconds.
+double new_delete_cost()
+{
+    const size_t rounds(500000);
+    auto start = std::chrono::steady_clock::now();
+    for (auto i(0u); i < rounds; ++i)
+    {
+        char *area = new char[area_len];
+        asm volatile("" : : "r"(area) : "memory"); // Or the pair is elided altogether.
+        delete[] area;
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / rounds;
+}
+
+/// Median of the values (partially reorders them).
+double median(std::vector<double> &values)
+{
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n_runs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 21;
+    if (n_runs == 0)
+        n_runs = 1;
+
+    std::vector<double> off(n_runs), on(n_runs);
+    for (auto i(0u); i < n_runs; ++i)
+    {
+        HeapProfiler::SetSamplingRate(0);
+        off[i] = new_delete_cost();
+        HeapProfiler::SetSamplingRate(HeapProfiler::DEFAULT_RATE);
+        on[i] = new_delete_cost();
+    }
+    double off_ns(median(off)), on_ns(median(on));
+
+    std::cout << ">>> ns per new/delete of " << area_len << " bytes, median of " << n_runs << " runs\n\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << ">>> sampling off: " << std::setw(8) << off_ns << "\n";
+    std::cout << ">>> default rate: " << std::setw(8) << on_ns << "  (" << (on_ns / off_ns - 1) * 100 << "% overhead)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
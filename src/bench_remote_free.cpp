@@ -0,0 +1,145 @@
+/**
+ * @file bench_remote_free.cpp
+ *
+ * @description
+ * Producer/consumer benchmark: objects are allocated on one thread and deleted on another.
+ *
+ * Compares a RemoteFreePool (lock-free remote frees, drained by the owner) with an
+ * SLPool behind a global lock, and with the default heap.
+ *
+ * Usage: bench_remote_free [objects]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <cstdlib>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/RemoteFreePool.hpp"
+
+using namespace mp;
+
+/// SLPool shared by every thread through a single lock.
+class LockedPool : public StoragePool
+{
+public:
+    explicit LockedPool(size_t bytes) : m_pool(bytes) {}
+
+    void *Allocate(size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_pool.Allocate(bytes);
+    }
+
+    void Free(void *ptr)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_pool.Free(ptr);
+    }
+
+private:
+    std::mutex m_lock;
+    SLPool<16> m_pool;
+};
+
+/// Single-producer/single-consumer ring of pointers.
+class Ring
+{
+public:
+    static const size_t CAPACITY = 1024;
+
+    bool Push(char *ptr)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == CAPACITY)
+            return false;
+        m_slots[head % CAPACITY] = ptr;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    char *Pop()
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return nullptr;
+        char *ptr = m_slots[tail % CAPACITY];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return ptr;
+    }
+
+private:
+    char *m_slots[CAPACITY];
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+const size_t object_len(64);
+
+/// Runs the pipeline with `allocate` on the producer side; returns millions of objects per second.
+template <typename Allocate>
+double run(size_t n_objects, Allocate allocate)
+{
+    Ring ring;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&ring, n_objects] {
+        for (size_t done = 0; done < n_objects;)
+        {
+            char *ptr = ring.Pop();
+            if (ptr == nullptr)
+                std::this_thread::yield();
+            else
+            {
+                delete[] ptr;
+                ++done;
+            }
+        }
+    });
+
+    for (size_t i = 0; i < n_objects; ++i)
+    {
+        char *ptr = allocate();
+        ptr[0] = char(i);
+        while (not ring.Push(ptr))
+            std::this_thread::yield();
+    }
+    consumer.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return n_objects / elapsed.count() / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n_objects = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    size_t pool_size = 4 * Ring::CAPACITY * (object_len + 64);
+
+    std::cout << ">>> Producer/consumer pipeline, " << n_objects << " objects of " << object_len << " bytes\n\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    {
+        RemoteFreePool<16> pool(pool_size);
+        double rate = run(n_objects, [&pool] { return new (pool) char[object_len]; });
+        std::cout << ">>> RemoteFreePool (lock-free remote frees): " << std::setw(8) << rate << " Mobjects/s" << std::endl;
+    }
+
+    {
+        LockedPool pool(pool_size);
+        double rate = run(n_objects, [&pool] { return new (pool) char[object_len]; });
+        std::cout << ">>> SLPool behind a global lock:             " << std::setw(8) << rate << " Mobjects/s" << std::endl;
+    }
+
+    {
+        double rate = run(n_objects, [] { return new char[object_len]; });
+        std::cout << ">>> Default heap:                            " << std::setw(8) << rate << " Mobjects/s" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,401 @@
+/**
+ * @file gremlins_preload.cpp
+ *
+ * @description
+ * malloc interposition library backed by GREMLINS arenas.
+ *
+ * Build the `gremlins_preload` target and run any unmodified binary with
+ *
+ *     LD_PRELOAD=./bin/libgremlins_preload.so ./program
+ *
+ * to serve every malloc/free/calloc/realloc/posix_memalign/... call from
+ * SLPool arenas. Each thread is bound to one of N_SHARDS shards; a shard owns
+ * a list of arenas (one SLPool over an anonymous mapping each) and a lock.
+ * Every area carries a Tag pointing to the arena that owns it, so memory freed
+ * by another thread still goes back to the right arena. Requests of
+ * DIRECT_THRESHOLD bytes or more get a mapping of their own.
+ *
+ * Nothing here depends on dynamic initialization: all globals are
+ * constant-initialized and arenas are mapped on first use, so malloc may be
+ * called before (or while) static constructors run.
+ */
+
+#define MP_NO_GLOBAL_NEW
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "../include/SLPool.hpp"
+
+#define GREMLINS_EXPORT extern "C" __attribute__((visibility("default")))
+
+namespace
+{
+using Pool = mp::SLPool<16>;
+using mp::Tag;
+
+constexpr size_t ALIGNMENT = 16;                   //!< Alignment of every pointer handed out (as glibc's malloc).
+constexpr size_t N_SHARDS = 8;                     //!< Number of independently locked arena lists.
+constexpr size_t ARENA_SZ = size_t(64) << 20;      //!< Bytes mapped for each arena.
+constexpr size_t DIRECT_THRESHOLD = size_t(1) << 20; //!< Requests this large bypass the arenas.
+
+size_t RoundUp(size_t value, size_t alignment)
+{
+  return (value + alignment - 1u) & ~(alignment - 1u);
+}
+
+/// Stores `value + slack` rounded up to `alignment` in `out`; false if that does not fit in a size_t.
+bool PaddedSize(size_t value, size_t slack, size_t alignment, size_t &out)
+{
+  if (__builtin_add_overflow(value, slack + alignment - 1u, &out))
+    return false;
+  out &= ~(alignment - 1u);
+
+  return true;
+}
+
+/// A StoragePool that also knows how many bytes the client may use in its areas.
+class Region : public mp::StoragePool
+{
+public:
+  void *Allocate(size_t) { return nullptr; } // Regions are only fed through the functions below.
+  virtual size_t UsableSize(Tag *tag) = 0;
+};
+
+class Arena;
+
+struct Shard
+{
+  std::mutex m_lock;             //!< Guards every arena of the shard.
+  Arena *m_arenas = nullptr;     //!< Arenas of the shard, newest first.
+};
+
+/// One SLPool over an anonymous mapping; the Arena object sits at the start of the mapping.
+class Arena : public Region
+{
+public:
+  Arena(Shard &shard, void *storage, size_t bytes) : m_shard(shard), m_pool(storage, bytes), m_next(shard.m_arenas)
+  { /* Empty */
+  }
+
+  /// Must be called with the shard lock held.
+  void *AllocateLocked(size_t bytes) noexcept
+  {
+    return m_pool.Allocate(bytes, std::nothrow);
+  }
+
+  void Free(void *ptr)
+  {
+    std::lock_guard<std::mutex> lock(m_shard.m_lock);
+    m_pool.Free(ptr);
+  }
+
+  size_t UsableSize(Tag *tag)
+  {
+    return Pool::UsableSize(tag) - sizeof(Tag);
+  }
+
+  Arena *Next() const { return m_next; }
+
+private:
+  Shard &m_shard; //!< Shard whose lock guards this arena.
+  Pool m_pool;    //!< The arena itself.
+  Arena *m_next;  //!< Next arena of the shard.
+};
+
+/// Requests served by a mapping of their own: [mapping length][Tag][client data].
+class DirectRegion : public Region
+{
+public:
+  void *AllocateMapped(size_t bytes) noexcept
+  {
+    size_t length;
+    if (not PaddedSize(bytes, ALIGNMENT, size_t(sysconf(_SC_PAGESIZE)), length))
+      return nullptr;
+
+    void *base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+      return nullptr;
+
+    *reinterpret_cast<size_t *>(base) = length;
+    Tag *tag = reinterpret_cast<Tag *>(reinterpret_cast<char *>(base) + ALIGNMENT) - 1U;
+    tag->pool = this;
+
+    return tag + 1U;
+  }
+
+  void Free(void *ptr)
+  {
+    void *base = reinterpret_cast<char *>(ptr) + sizeof(Tag) - ALIGNMENT;
+    munmap(base, *reinterpret_cast<size_t *>(base));
+  }
+
+  size_t UsableSize(Tag *tag)
+  {
+    void *base = reinterpret_cast<char *>(tag) + sizeof(Tag) - ALIGNMENT;
+    return *reinterpret_cast<size_t *>(base) - ALIGNMENT;
+  }
+};
+
+/// Over-aligned requests: [offset][Tag][aligned client data] carved out of a regular area.
+class AlignedRegion : public Region
+{
+public:
+  void Free(void *ptr);
+
+  size_t UsableSize(Tag *tag);
+
+  static size_t &Offset(Tag *tag)
+  {
+    return reinterpret_cast<size_t *>(tag)[-1];
+  }
+};
+
+Shard g_shards[N_SHARDS];
+DirectRegion g_direct;
+AlignedRegion g_aligned;
+std::atomic<unsigned> g_next_shard{0u};
+__attribute__((tls_model("initial-exec"))) thread_local Shard *t_shard = nullptr;
+
+Shard &ThreadShard()
+{
+  if (t_shard == nullptr)
+    t_shard = &g_shards[g_next_shard.fetch_add(1u, std::memory_order_relaxed) % N_SHARDS];
+
+  return *t_shard;
+}
+
+Region *Owner(void *ptr)
+{
+  return static_cast<Region *>(mp::TagOf(ptr)->pool);
+}
+
+void *AllocateTagged(size_t bytes)
+{
+  if (bytes >= DIRECT_THRESHOLD)
+    return g_direct.AllocateMapped(bytes);
+
+  Shard &shard = ThreadShard();
+  std::lock_guard<std::mutex> lock(shard.m_lock);
+
+  Tag *tag = nullptr;
+  Arena *owner = shard.m_arenas;
+  for (; owner != nullptr; owner = owner->Next())
+  {
+    tag = reinterpret_cast<Tag *>(owner->AllocateLocked(bytes + sizeof(Tag)));
+    if (tag != nullptr)
+      break;
+  }
+
+  if (tag == nullptr)
+  {
+    void *base = mmap(nullptr, ARENA_SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+      return nullptr;
+
+    size_t offset = RoundUp(sizeof(Arena), ALIGNMENT);
+    owner = new (base) Arena(shard, reinterpret_cast<char *>(base) + offset, ARENA_SZ - offset);
+    shard.m_arenas = owner;
+
+    tag = reinterpret_cast<Tag *>(owner->AllocateLocked(bytes + sizeof(Tag)));
+    if (tag == nullptr)
+      return nullptr;
+  }
+
+  tag->pool = owner;
+  return tag + 1U;
+}
+
+void FreeTagged(void *ptr)
+{
+  Tag *const tag = mp::TagOf(ptr);
+  tag->pool->Free(tag);
+}
+
+void AlignedRegion::Free(void *ptr)
+{
+  Tag *tag = reinterpret_cast<Tag *>(ptr);
+  FreeTagged(reinterpret_cast<char *>(tag + 1U) - Offset(tag));
+}
+
+size_t AlignedRegion::UsableSize(Tag *tag)
+{
+  void *raw = reinterpret_cast<char *>(tag + 1U) - Offset(tag);
+  return Owner(raw)->UsableSize(reinterpret_cast<Tag *>(raw) - 1U) - Offset(tag);
+}
+
+void *AllocateAligned(size_t alignment, size_t bytes)
+{
+  if (alignment <= ALIGNMENT)
+    return AllocateTagged(bytes);
+
+  // Room for the redirection (offset + Tag) in front of the aligned pointer.
+  size_t padded;
+  if (__builtin_add_overflow(bytes, alignment + ALIGNMENT, &padded))
+    return nullptr;
+
+  char *raw = reinterpret_cast<char *>(AllocateTagged(padded));
+  if (raw == nullptr)
+    return nullptr;
+
+  char *aligned = reinterpret_cast<char *>(RoundUp(reinterpret_cast<uintptr_t>(raw) + ALIGNMENT, alignment));
+  Tag *tag = reinterpret_cast<Tag *>(aligned) - 1U;
+  tag->pool = &g_aligned;
+  AlignedRegion::Offset(tag) = aligned - raw;
+
+  return aligned;
+}
+
+size_t UsableSize(void *ptr)
+{
+  return Owner(ptr)->UsableSize(mp::TagOf(ptr));
+}
+
+// A fork() while another thread holds a shard lock would leave the child deadlocked.
+void LockShards()
+{
+  for (auto &shard : g_shards)
+    shard.m_lock.lock();
+}
+
+void UnlockShards()
+{
+  for (auto &shard : g_shards)
+    shard.m_lock.unlock();
+}
+
+__attribute__((constructor)) void RegisterForkHandlers()
+{
+  pthread_atfork(&LockShards, &UnlockShards, &UnlockShards);
+}
+} // namespace
+
+GREMLINS_EXPORT void *malloc(size_t bytes)
+{
+  void *ptr = AllocateTagged(bytes);
+  if (ptr == nullptr)
+    errno = ENOMEM;
+
+  return ptr;
+}
+
+GREMLINS_EXPORT void free(void *ptr)
+{
+  if (ptr != nullptr)
+    FreeTagged(ptr);
+}
+
+GREMLINS_EXPORT void *calloc(size_t count, size_t size)
+{
+  size_t bytes;
+  if (__builtin_mul_overflow(count, size, &bytes))
+  {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  void *ptr = malloc(bytes);
+  if (ptr != nullptr and Owner(ptr) != &g_direct) // Fresh mappings are already zeroed.
+    memset(ptr, 0, bytes);
+
+  return ptr;
+}
+
+GREMLINS_EXPORT void *realloc(void *ptr, size_t bytes)
+{
+  if (ptr == nullptr)
+    return malloc(bytes);
+
+  if (bytes == 0u)
+  {
+    free(ptr);
+    return nullptr;
+  }
+
+  size_t usable = UsableSize(ptr);
+  if (bytes <= usable)
+    return ptr;
+
+  void *moved = malloc(bytes);
+  if (moved != nullptr)
+  {
+    memcpy(moved, ptr, usable);
+    free(ptr);
+  }
+
+  return moved;
+}
+
+GREMLINS_EXPORT void *reallocarray(void *ptr, size_t count, size_t size)
+{
+  size_t bytes;
+  if (__builtin_mul_overflow(count, size, &bytes))
+  {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  return realloc(ptr, bytes);
+}
+
+GREMLINS_EXPORT int posix_memalign(void **out, size_t alignment, size_t bytes)
+{
+  if (alignment == 0u or alignment % sizeof(void *) != 0u or (alignment & (alignment - 1u)) != 0u)
+    return EINVAL;
+
+  void *ptr = AllocateAligned(alignment, bytes);
+  if (ptr == nullptr)
+    return ENOMEM;
+
+  *out = ptr;
+  return 0;
+}
+
+GREMLINS_EXPORT void *aligned_alloc(size_t alignment, size_t bytes)
+{
+  if (alignment == 0u or (alignment & (alignment - 1u)) != 0u)
+  {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  void *ptr = AllocateAligned(alignment, bytes);
+  if (ptr == nullptr)
+    errno = ENOMEM;
+
+  return ptr;
+}
+
+GREMLINS_EXPORT void *memalign(size_t alignment, size_t bytes)
+{
+  return aligned_alloc(alignment, bytes);
+}
+
+GREMLINS_EXPORT void *valloc(size_t bytes)
+{
+  return aligned_alloc(size_t(sysconf(_SC_PAGESIZE)), bytes);
+}
+
+GREMLINS_EXPORT void *pvalloc(size_t bytes)
+{
+  size_t page = size_t(sysconf(_SC_PAGESIZE)), rounded;
+  if (not PaddedSize(bytes, 0u, page, rounded))
+  {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  return aligned_alloc(page, rounded);
+}
+
+GREMLINS_EXPORT size_t malloc_usable_size(void *ptr)
+{
+  return ptr == nullptr ? 0u : UsableSize(ptr);
+}
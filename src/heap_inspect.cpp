@@ -0,0 +1,135 @@
+/**
+ * @file heap_inspect.cpp
+ *
+ * @description
+ * Reads a binary heap map (see HeapInspector) and shows how fragmented the pool was.
+ *
+ *     heap_inspect <map> [--width N]   summary, free area sizes and a map of the pool
+ *     heap_inspect <map> --json        the same heap map, as JSON
+ *
+ * In the map each character stands for an equal slice of the pool and shows how
+ * much of it was reserved: ' ' none, '.' up to a quarter, ':' up to a half,
+ * '+' up to three quarters, '#' more.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "../include/HeapInspector.hpp"
+
+using namespace mp;
+
+/// Prints how many free areas fall in each power-of-two size class.
+void histogram(const HeapMap &map)
+{
+    std::vector<size_t> classes;
+    map.Walk([&classes](const void *, size_t bytes, bool free) {
+        if (not free)
+            return;
+        size_t c(0u);
+        while ((size_t(2) << c) <= bytes)
+            ++c;
+        if (classes.size() <= c)
+            classes.resize(c + 1u, 0u);
+        ++classes[c];
+    });
+
+    size_t most = classes.empty() ? 0u : *std::max_element(classes.begin(), classes.end());
+    std::cout << ">>> Free areas by size:\n";
+    for (size_t c = 0; c < classes.size(); ++c)
+    {
+        if (classes[c] == 0u)
+            continue;
+        std::cout << std::setw(12) << (size_t(1) << c) << " B+ " << std::setw(10) << classes[c] << " "
+                  << std::string((classes[c] * 50 + most - 1) / most, '*') << "\n";
+    }
+}
+
+/// Prints the pool in at most 16 lines of `width` characters.
+void picture(const HeapMap &map, size_t width)
+{
+    uint64_t total(0u);
+    for (const HeapMap::Area &area : map.m_areas)
+        total += area.m_bytes;
+    if (total == 0u)
+        return;
+
+    const size_t cells = std::min<uint64_t>(width * 16u, total / map.m_block);
+    std::vector<double> used(cells, 0.0);
+    const double cell_bytes = double(total) / cells;
+
+    // Spread each reserved area over the cells it overlaps.
+    for (const HeapMap::Area &area : map.m_areas)
+    {
+        if (area.m_free)
+            continue;
+        double begin = area.m_offset, end = area.m_offset + area.m_bytes;
+        for (size_t c = size_t(begin / cell_bytes); c < cells and c * cell_bytes < end; ++c)
+            used[c] += std::min(end, (c + 1) * cell_bytes) - std::max(begin, c * cell_bytes);
+    }
+
+    const char shades[] = " .:+#";
+    std::cout << ">>> Pool map (" << std::fixed << std::setprecision(0) << cell_bytes << " bytes per character):\n";
+    for (size_t c = 0; c < cells; ++c)
+    {
+        double fill = used[c] / cell_bytes;
+        std::cout << (c % width == 0 ? "|" : "") << shades[fill <= 0.0 ? 0 : std::min(4, 1 + int(fill * 4 - 1e-9))]
+                  << ((c + 1) % width == 0 or c + 1 == cells ? "|\n" : "");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = nullptr;
+    size_t width(64u);
+    bool json(false);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (std::strcmp(argv[i], "--width") == 0 and i + 1 < argc)
+            width = std::max(8, std::atoi(argv[++i]));
+        else
+            path = argv[i];
+    }
+
+    if (path == nullptr)
+    {
+        std::cerr << "Usage: " << argv[0] << " <heap map> [--width N] [--json]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    HeapMap map;
+    if (not HeapInspector::ReadBinary(file, map))
+    {
+        std::cerr << ">>> " << path << " is not a heap map.\n";
+        return EXIT_FAILURE;
+    }
+
+    if (json)
+    {
+        HeapInspector::WriteJson(map, map.m_block, std::cout);
+        return EXIT_SUCCESS;
+    }
+
+    HeapSummary summary = HeapInspector::Summarize(map);
+    std::cout << ">>> Heap map of the pool at 0x" << std::hex << map.m_base << std::dec << " (" << map.m_block << "-byte blocks)\n\n";
+    std::cout << ">>> Areas: " << summary.m_areas << " (" << summary.m_free_areas << " free)\n";
+    std::cout << ">>> Reserved bytes: " << summary.m_used_bytes << "\n";
+    std::cout << ">>> Free bytes: " << summary.m_free_bytes << " (largest free area: " << summary.m_largest_free << ")\n";
+    std::cout << ">>> Fragmentation: " << std::fixed << std::setprecision(1) << 100 * summary.Fragmentation() << "%\n\n";
+
+    histogram(map);
+    std::cout << "\n";
+    picture(map, width);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file test_bitmap_integrity.cpp
+ *
+ * @description
+ * Test the bitmap pool's integrity after basic allocate/free operations.
+ *
+ * 1) Test the bad_alloc exception (every slot is reserved).
+ * 2) Test the bad_alloc exception (request larger than a slot).
+ * 3) Test data integrity after freeing and reallocating interleaved slots.
+ * 4) Test the reserved slot count after a bulk free.
+ * 5) Test the search across several bitmap words (wrap around the hint).
+ * 6) Test the search skipping many full words (the AVX2 path, where the CPU has it).
+ */
+
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <vector>
+
+#include "../include/mempool_common.h"
+#include "../include/BitmapPool.hpp"
+
+using namespace mp;
+
+int main()
+{
+    const short BLOCK_SIZE = 32;
+    using byte = char;
+    const short slot_len(BLOCK_SIZE - BitmapPool<BLOCK_SIZE>::TAG_SZ); // Largest request served by one slot.
+
+    // Enough slots to span several bitmap words, with a partial last word.
+    const short n_chunks(1000);
+
+    auto failures(0);
+
+    std::cout << ">>> Begining BITMAP INTEGRITY tests...\n\n";
+
+    {
+        mp::BitmapPool<BLOCK_SIZE> p(BLOCK_SIZE * n_chunks);
+        std::cout << p << std::endl;
+
+        for (auto i(0); i < n_chunks; ++i)
+            new (p) byte[slot_len];
+
+        bool passed(false);
+        try
+        {
+            new (p) byte[1];
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = true;
+        }
+
+        passed = passed and p.Reserved() == size_t(n_chunks);
+        failures += not passed;
+        std::cout << ">>> Testing pool overflow... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        mp::BitmapPool<BLOCK_SIZE> p(BLOCK_SIZE * n_chunks);
+
+        bool passed(false);
+        try
+        {
+            new (p) byte[slot_len + 1];
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = true;
+        }
+
+        passed = passed and p.Reserved() == 0u;
+        failures += not passed;
+        std::cout << ">>> Testing request larger than a slot... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        mp::BitmapPool<BLOCK_SIZE> p(BLOCK_SIZE * n_chunks);
+        byte *vet[n_chunks];
+
+        // Fill up the char arrays with "01234567890123...." and its reverse.
+        std::ostringstream oss;
+        auto j(0u);
+        while (j < slot_len - 1u) // Remember we have to reserve one extra space for the '\0'.
+            oss << (j++ % 10);
+        std::string reference_a(oss.str());
+        std::string reference_b(reference_a.rbegin(), reference_a.rend());
+
+        for (auto i(0); i < n_chunks; ++i)
+        {
+            vet[i] = new (p) byte[slot_len];
+            strcpy(vet[i], reference_a.c_str());
+        }
+
+        for (auto i(1); i < n_chunks; i += 2)
+            delete[] vet[i];
+
+        for (auto i(1); i < n_chunks; i += 2)
+        {
+            vet[i] = new (p) byte[slot_len];
+            strcpy(vet[i], reference_b.c_str());
+        }
+
+        bool passed(true);
+        for (auto i(0); i < n_chunks and passed; ++i)
+            passed = strcmp((i % 2 == 0 ? reference_a : reference_b).c_str(), vet[i]) == 0;
+
+        failures += not passed;
+        std::cout << ">>> Testing pool integrity after deleting and realocating interleaved slots... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        mp::BitmapPool<BLOCK_SIZE> p(BLOCK_SIZE * n_chunks);
+
+        for (auto i(0); i < n_chunks / 2; ++i)
+            new (p) byte[slot_len];
+
+        size_t visited(0u);
+        p.ForEachReserved([&visited](void *) { ++visited; });
+
+        bool passed = visited == size_t(n_chunks / 2) and p.Reserved() == visited;
+        p.FreeAll();
+        passed = passed and p.Reserved() == 0u;
+
+        // Every slot must be available again.
+        for (auto i(0); i < n_chunks; ++i)
+            new (p) byte[slot_len];
+        passed = passed and p.Reserved() == size_t(n_chunks);
+
+        failures += not passed;
+        std::cout << ">>> Testing reserved count after a bulk free... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        mp::BitmapPool<BLOCK_SIZE> p(BLOCK_SIZE * n_chunks);
+        byte *vet[n_chunks];
+
+        for (auto i(0); i < n_chunks; ++i)
+            vet[i] = new (p) byte[slot_len];
+
+        // Free one slot in the first word, while the search hint sits at the end.
+        delete[] vet[3];
+        byte *again = new (p) byte[slot_len];
+
+        bool passed = again == vet[3];
+        failures += not passed;
+        std::cout << ">>> Testing free slot search wrapping around the hint... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        // 64 words: the search from the hint must cross whole 8-word strides to reach the free slot.
+        const size_t n_slots(64 * BitmapPool<BLOCK_SIZE>::WORD_BITS);
+        mp::BitmapPool<BLOCK_SIZE> p(BLOCK_SIZE * n_slots);
+        std::vector<byte *> vet(n_slots);
+
+        for (auto &slot : vet)
+            slot = new (p) byte[slot_len];
+
+        bool passed(true);
+        for (size_t word : {1u, 8u, 15u, 16u, 40u, 63u})
+        {
+            size_t far = word * BitmapPool<BLOCK_SIZE>::WORD_BITS + 17u;
+
+            // Bring the hint back to the first word (the search wraps around to it)...
+            delete[] vet[0];
+            passed = passed and new (p) byte[slot_len] == vet[0];
+
+            // ... then leave a single free slot far past it.
+            delete[] vet[far];
+            passed = passed and new (p) byte[slot_len] == vet[far];
+        }
+        passed = passed and p.Reserved() == n_slots;
+
+        failures += not passed;
+        std::cout << ">>> Testing free slot search across full words"
+                  << (__builtin_cpu_supports("avx2") ? " (AVX2)" : " (scalar)") << "... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file test_cache_aligned_pool.cpp
+ *
+ * @description
+ * Test the cache-line layouts of CacheAlignedPool.
+ *
+ * 1) WHOLE_LINES: no two areas (metadata included) share a cache line.
+ * 2) DATA_ON_LINE: objects built with new (pool) begin on a cache line, and their
+ *    Header and Tag sit in a line of their own.
+ * 3) Both layouts keep the data intact and are whole again after everything is freed.
+ */
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+#include "../include/mempool_common.h"
+#include "../include/CacheAlignedPool.hpp"
+
+using namespace mp;
+
+using Pool = CacheAlignedPool<64>;
+
+/// Line of the byte at `ptr`.
+uintptr_t line(const void *ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) / Pool::LINE_SZ;
+}
+
+/// Reserves random objects with new (pool); checks the layout, the contents, and that the pool is whole afterwards.
+bool run(Pool::Layout layout)
+{
+    const size_t pool_size(1u << 20);
+    const size_t n_objects(2000);
+    Pool p(pool_size, layout);
+    std::mt19937 g(2018);
+    bool passed(true);
+
+    struct Object
+    {
+        char *m_data;
+        size_t m_bytes;
+    };
+    std::vector<Object> objects;
+
+    for (size_t i = 0; i < n_objects; ++i)
+    {
+        size_t bytes = 1 + g() % 200;
+        char *data = new (p) char[bytes];
+        std::memset(data, char(i), bytes);
+        objects.push_back(Object{data, bytes});
+
+        // First byte of the area: the Header, HEADER_SZ + TAG_SZ (+ PAD) bytes before the data.
+        const char *area = data - Pool::TAG_SZ - Pool::HEADER_SZ - (layout == Pool::DATA_ON_LINE ? Pool::PAD : 0u);
+        passed = passed and reinterpret_cast<uintptr_t>(area) % Pool::LINE_SZ == 0u;
+        if (layout == Pool::DATA_ON_LINE)
+            passed = passed and reinterpret_cast<uintptr_t>(data) % Pool::LINE_SZ == 0u and line(data - 1) == line(area);
+
+        // Free one object in three, so that later areas land between older ones.
+        if (g() % 3 == 0)
+        {
+            Object victim = objects[g() % objects.size()];
+            for (size_t k = 0; k < victim.m_bytes; ++k)
+                passed = passed and victim.m_data[k] == victim.m_data[0];
+            delete[] victim.m_data;
+            for (auto &object : objects)
+                if (object.m_data == victim.m_data)
+                {
+                    object = objects.back();
+                    objects.pop_back();
+                    break;
+                }
+        }
+    }
+
+    // No line holds the end of one area and the start of another.
+    for (auto &a : objects)
+        for (auto &b : objects)
+            if (a.m_data < b.m_data)
+                passed = passed and line(a.m_data + a.m_bytes - 1) < line(b.m_data - Pool::TAG_SZ - Pool::HEADER_SZ);
+
+    for (auto &object : objects)
+    {
+        for (size_t k = 0; k < object.m_bytes; ++k)
+            passed = passed and object.m_data[k] == object.m_data[0];
+        delete[] object.m_data;
+    }
+
+    try
+    {
+        p.Free(p.Allocate(pool_size));
+    }
+    catch (std::bad_alloc &e)
+    {
+        passed = false;
+    }
+
+    return passed;
+}
+
+int main()
+{
+    auto failures(0);
+
+    std::cout << ">>> Begining CACHE ALIGNED POOL tests...\n\n";
+
+    {
+        bool passed = run(Pool::WHOLE_LINES);
+        failures += not passed;
+        std::cout << ">>> Testing areas made of whole lines... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed = run(Pool::DATA_ON_LINE);
+        failures += not passed;
+        std::cout << ">>> Testing data on a line, metadata out of it... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_containers.cpp
+ *
+ * @description
+ * Test the pool containers against the standard library.
+ *
+ * 1) PoolList keeps the same sequence as std::list under pushes, pops and erasures.
+ * 2) PoolHashMap finds the same entries as std::map under random inserts and erasures.
+ * 3) PoolTree finds the same entries as std::map, in order, and stays balanced.
+ * 4) Over-aligned values are aligned, though pool areas are only 8-byte aligned.
+ * 5) Destroying the containers gives every byte back to the pool.
+ */
+
+#include <iostream>
+#include <random>
+#include <list>
+#include <map>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/PoolList.hpp"
+#include "../include/PoolHashMap.hpp"
+#include "../include/PoolTree.hpp"
+
+using namespace mp;
+
+int main()
+{
+    const size_t pool_size(8u << 20);
+    const int n_ops(200000);
+    SLPool<16> p(pool_size);
+    std::mt19937 g(2018);
+    auto failures(0);
+
+    std::cout << ">>> Begining CONTAINERS tests...\n\n";
+
+    {
+        PoolList<int> list(p);
+        std::list<int> model;
+
+        for (auto i(0); i < n_ops; ++i)
+        {
+            switch (g() % 4)
+            {
+            case 0:
+                list.PushBack(i);
+                model.push_back(i);
+                break;
+            case 1:
+                list.PushFront(i);
+                model.push_front(i);
+                break;
+            case 2:
+                if (not model.empty())
+                {
+                    list.PopFront();
+                    model.pop_front();
+                }
+                break;
+            default:
+                // Erase the third element from the back.
+                auto it = list.end();
+                auto mit = model.end();
+                for (auto k(0); k < 3 and it != list.begin(); ++k)
+                {
+                    --it;
+                    --mit;
+                }
+                if (it != list.end())
+                {
+                    list.Erase(it);
+                    model.erase(mit);
+                }
+            }
+        }
+
+        bool passed = list.Size() == model.size() and std::equal(model.begin(), model.end(), list.begin());
+        failures += not passed;
+        std::cout << ">>> Testing PoolList against std::list... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        PoolHashMap<int, int> map(p);
+        std::map<int, int> model;
+
+        for (auto i(0); i < n_ops; ++i)
+        {
+            int key = g() % (n_ops / 4);
+            if (g() % 3 == 0)
+            {
+                if (map.Erase(key) != (model.erase(key) == 1))
+                    break;
+            }
+            else
+            {
+                map[key] = i;
+                model[key] = i;
+            }
+        }
+
+        bool passed = map.Size() == model.size();
+        for (auto &entry : model)
+            passed = passed and map.Find(entry.first) != nullptr and *map.Find(entry.first) == entry.second;
+        for (auto key(0); key < n_ops / 4; ++key)
+            passed = passed and (map.Find(key) != nullptr) == (model.count(key) == 1);
+
+        failures += not passed;
+        std::cout << ">>> Testing PoolHashMap against std::map... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        PoolTree<int, int> tree(p);
+        std::map<int, int> model;
+
+        for (auto i(0); i < n_ops; ++i)
+        {
+            int key = g() % (n_ops / 4);
+            if (g() % 3 == 0)
+            {
+                if (tree.Erase(key) != (model.erase(key) == 1))
+                    break;
+            }
+            else
+            {
+                tree[key] = i;
+                model[key] = i;
+            }
+        }
+
+        std::vector<std::pair<int, int>> entries;
+        tree.ForEach([&entries](int key, int value) { entries.push_back(std::make_pair(key, value)); });
+
+        bool passed = tree.Size() == model.size() and std::equal(model.begin(), model.end(), entries.begin(),
+                                                                  [](const std::pair<const int, int> &a, const std::pair<int, int> &b) { return a.first == b.first and a.second == b.second; });
+        passed = passed and tree.Height() <= 1.45 * std::log2(model.size() + 2);
+
+        failures += not passed;
+        std::cout << ">>> Testing PoolTree against std::map (height " << tree.Height() << ")... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        struct alignas(32) Wide
+        {
+            long m_value;
+        };
+        auto aligned = [](const Wide &value) { return reinterpret_cast<uintptr_t>(&value) % alignof(Wide) == 0u; };
+
+        PoolList<Wide> list(p);
+        PoolHashMap<int, Wide> map(p);
+        PoolTree<int, Wide> tree(p);
+        for (auto i(0); i < 1000; ++i)
+        {
+            list.PushBack(Wide{i});
+            map[i] = Wide{i};
+            tree[i] = Wide{i};
+        }
+
+        bool passed(true);
+        for (auto &value : list)
+            passed = passed and aligned(value);
+        for (auto i(0); i < 1000; ++i)
+            passed = passed and aligned(*map.Find(i)) and map.Find(i)->m_value == i;
+        tree.ForEach([&](int key, const Wide &value) { passed = passed and aligned(value) and value.m_value == key; });
+
+        failures += not passed;
+        std::cout << ">>> Testing over-aligned values in every container... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed(true);
+        try
+        {
+            p.Free(p.Allocate(pool_size));
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = false;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing the pool is whole again after destroying the containers... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
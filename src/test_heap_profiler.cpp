@@ -0,0 +1,189 @@
+/**
+ * @file test_heap_profiler.cpp
+ *
+ * @description
+ * Test the sampling heap profiler hooked into the operator new/delete (built with MP_HEAP_PROFILER).
+ *
+ * 1) The estimated live heap is close to the bytes actually reserved from a pool.
+ * 2) The folded-stack profile names the call site that reserved them.
+ * 3) Deleting the areas forgets their samples.
+ * 4) Samples the table can't hold are counted and reported in the profile.
+ * 5) The table grows past its initial capacity without dropping samples.
+ * 6) At the default rate, about one allocation is sampled every DEFAULT_RATE bytes, so sampling costs little.
+ *    (bench_heap_profiler measures the time it takes.)
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+
+using namespace mp;
+
+const size_t n_areas(100000);
+const size_t area_len(64);
+
+__attribute__((noinline)) void fill_pool(StoragePool &p, char **vet, size_t n = n_areas)
+{
+    for (auto i(0u); i < n; ++i)
+        vet[i] = new (p) char[area_len];
+}
+
+/// Samples every allocation from now on.
+void sample_everything()
+{
+    HeapProfiler::SetSamplingRate(1);
+    // Use up the distance to the next sample drawn at the previous rate.
+    char *area = new char[2 * HeapProfiler::DEFAULT_RATE];
+    asm volatile("" : : "r"(area) : "memory");
+    delete[] area;
+}
+
+/// Contents of the folded profile.
+std::string profile()
+{
+    const char *path("test_heap_profiler.folded");
+    std::string contents;
+    if (HeapProfiler::Dump(path))
+    {
+        std::ifstream file(path);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        contents = buffer.str();
+    }
+    std::remove(path);
+    return contents;
+}
+
+/// Size of the address space of this process, in bytes.
+size_t address_space()
+{
+    size_t pages(0);
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages;
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+int main()
+{
+    auto failures(0);
+    const size_t expected(n_areas * area_len);
+
+    std::cout << ">>> Begining HEAP PROFILER tests...\n\n";
+
+    {
+        // A small rate gives enough samples for a tight estimate.
+        HeapProfiler::SetSamplingRate(4096);
+
+        SLPool<16> p(n_areas * (area_len + 64));
+        char **vet = new char *[n_areas];
+        size_t baseline(HeapProfiler::LiveBytes());
+        fill_pool(p, vet);
+
+        double estimated(HeapProfiler::LiveBytes() - baseline);
+        bool passed = estimated > 0.8 * expected and estimated < 1.2 * expected;
+        failures += not passed;
+        std::cout << ">>> Testing live heap estimate (" << estimated / expected * 100 << "% of the real size)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        passed = profile().find("fill_pool") != std::string::npos;
+
+        failures += not passed;
+        std::cout << ">>> Testing call site in the folded profile... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        for (auto i(0u); i < n_areas; ++i)
+            delete[] vet[i];
+
+        passed = HeapProfiler::LiveBytes() == baseline;
+        failures += not passed;
+        std::cout << ">>> Testing samples are forgotten on delete... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        delete[] vet;
+    }
+
+    {
+        // The table still has its initial slots; with no address space left it can't grow.
+        const size_t n_samples(HeapProfiler::CAPACITY);
+        SLPool<16> p(n_samples * (area_len + 64));
+        char **vet = new char *[n_samples];
+        size_t baseline(HeapProfiler::LiveSamples());
+
+        struct rlimit saved, limit;
+        sample_everything();
+        getrlimit(RLIMIT_AS, &saved);
+        limit = saved;
+        limit.rlim_cur = address_space() + (1u << 20);
+        bool passed = setrlimit(RLIMIT_AS, &limit) == 0;
+
+        fill_pool(p, vet, n_samples);
+        HeapProfiler::SetSamplingRate(0);
+        setrlimit(RLIMIT_AS, &saved);
+
+        size_t dropped(HeapProfiler::Dropped());
+        passed = passed and dropped > 0u and HeapProfiler::LiveSamples() - baseline + dropped == n_samples and
+                 profile().find("[dropped] ") != std::string::npos;
+        failures += not passed;
+        std::cout << ">>> Testing dropped samples are reported (" << dropped << " dropped)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        for (auto i(0u); i < n_samples; ++i)
+            delete[] vet[i];
+        delete[] vet;
+    }
+
+    {
+        const size_t n_samples(4 * HeapProfiler::CAPACITY);
+        SLPool<16> p(n_samples * (area_len + 64));
+        char **vet = new char *[n_samples];
+        size_t baseline(HeapProfiler::LiveSamples()), dropped(HeapProfiler::Dropped());
+
+        sample_everything();
+        fill_pool(p, vet, n_samples);
+        HeapProfiler::SetSamplingRate(0);
+
+        bool passed = HeapProfiler::LiveSamples() - baseline == n_samples and HeapProfiler::Dropped() == dropped;
+        for (auto i(0u); i < n_samples; ++i)
+            delete[] vet[i];
+        passed = passed and HeapProfiler::LiveSamples() == baseline;
+
+        failures += not passed;
+        std::cout << ">>> Testing the table grows instead of dropping samples... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        delete[] vet;
+    }
+
+    {
+        // Sampling is the only slow path, so its cost follows the number of samples.
+        const size_t n_large(1u << 16), large_len(1024);
+        const double expected_samples(double(n_large * large_len) / HeapProfiler::DEFAULT_RATE);
+        SLPool<16> p(n_large * (large_len + 64));
+        char **vet = new char *[n_large];
+        size_t baseline(HeapProfiler::LiveSamples());
+
+        HeapProfiler::SetSamplingRate(HeapProfiler::DEFAULT_RATE);
+        for (auto i(0u); i < n_large; ++i)
+            vet[i] = new (p) char[large_len];
+        HeapProfiler::SetSamplingRate(0);
+
+        double samples(HeapProfiler::LiveSamples() - baseline);
+        bool passed = samples > 0.5 * expected_samples and samples < 1.5 * expected_samples;
+        for (auto i(0u); i < n_large; ++i)
+            delete[] vet[i];
+        delete[] vet;
+
+        failures += not passed;
+        std::cout << ">>> Testing sampling rate (" << samples << " samples, " << expected_samples << " expected)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
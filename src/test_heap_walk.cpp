@@ -0,0 +1,246 @@
+/**
+ * @file test_heap_walk.cpp
+ *
+ * @description
+ * Test the heap walker of SLPool and the heap maps exported from it.
+ *
+ * 1) The walk tiles the pool: areas are contiguous and add up to its size.
+ * 2) Free areas are flagged as such, and match the free list.
+ * 3) Reserved areas are exactly the ones handed to the client.
+ * 4) A binary map, written to a file and read back, is the same walk; so is one written to a pipe,
+ *    whose area count is left open.
+ * 5) The JSON map lists every area.
+ * 6) Walking a pool of a few million blocks takes milliseconds.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/HeapInspector.hpp"
+
+using namespace mp;
+
+struct Area
+{
+    const void *m_area;
+    size_t m_bytes;
+    bool m_free;
+
+    bool operator==(const Area &other) const
+    {
+        return m_area == other.m_area and m_bytes == other.m_bytes and m_free == other.m_free;
+    }
+};
+
+/// Every area of `heap`, in address order.
+template <typename Heap>
+std::vector<Area> walk(const Heap &heap)
+{
+    std::vector<Area> areas;
+    heap.Walk([&areas](const void *area, size_t bytes, bool free) { areas.push_back(Area{area, bytes, free}); });
+    return areas;
+}
+
+/// Whether `areas` are contiguous and cover `bytes` bytes.
+bool tiles(const std::vector<Area> &areas, size_t bytes)
+{
+    size_t total(0u);
+    for (size_t i = 0; i < areas.size(); ++i)
+    {
+        if (i > 0 and static_cast<const char *>(areas[i - 1].m_area) + areas[i - 1].m_bytes != areas[i].m_area)
+            return false;
+        total += areas[i].m_bytes;
+    }
+    return total == bytes;
+}
+
+int main()
+{
+    const size_t pool_size(1u << 20);
+    const size_t blk_size(16u);
+    auto failures(0);
+
+    std::cout << ">>> Begining HEAP WALK tests...\n\n";
+
+    SLPool<16> p(pool_size);
+    std::mt19937 g(42);
+    std::vector<char *> reserved;
+    for (auto i(0); i < 2000; ++i)
+        reserved.push_back(new (p) char[1 + g() % 500]);
+    std::shuffle(reserved.begin(), reserved.end(), g);
+    for (auto i(0); i < 1000; ++i)
+        delete[] reserved[i];
+    reserved.erase(reserved.begin(), reserved.begin() + 1000);
+
+    // The pool's capacity: everything but the sentinel.
+    size_t capacity(0u);
+    {
+        std::vector<Area> whole = walk(SLPool<16>(pool_size));
+        capacity = whole.size() == 1u and whole[0].m_free ? whole[0].m_bytes : 0u;
+    }
+    const std::vector<Area> areas = walk(p);
+
+    {
+        bool passed = capacity > 0u and tiles(areas, capacity);
+
+        failures += not passed;
+        std::cout << ">>> Testing the walk tiles the pool (" << areas.size() << " areas)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        std::vector<Area> free_list, free_walk;
+        p.ForEachFree([&free_list](const void *area, size_t bytes) { free_list.push_back(Area{area, bytes, true}); });
+        std::copy_if(areas.begin(), areas.end(), std::back_inserter(free_walk), [](const Area &a) { return a.m_free; });
+
+        // No two free areas are neighbours either, they would have been merged.
+        bool passed = free_walk == free_list and not free_list.empty();
+        for (size_t i = 1; i < areas.size(); ++i)
+            passed = passed and not(areas[i - 1].m_free and areas[i].m_free);
+
+        failures += not passed;
+        std::cout << ">>> Testing free areas match the free list (" << free_list.size() << " areas)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        // The client's data sits right after the Header and the Tag of each reserved area.
+        std::vector<const void *> used;
+        for (const Area &area : areas)
+            if (not area.m_free)
+                used.push_back(static_cast<const char *>(area.m_area) + SLPool<16>::HEADER_SZ + SLPool<16>::TAG_SZ);
+        std::vector<const void *> expected(reserved.begin(), reserved.end());
+        std::sort(expected.begin(), expected.end());
+
+        bool passed = used == expected;
+
+        failures += not passed;
+        std::cout << ">>> Testing reserved areas are the client's... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        char path[] = "/tmp/heap_walk_XXXXXX";
+        int fd = mkstemp(path);
+        bool passed = fd >= 0 and HeapInspector::WriteBinary(p, blk_size, fd);
+        if (fd >= 0)
+            close(fd);
+
+        HeapMap map;
+        std::ifstream file(path, std::ios::binary);
+        passed = passed and HeapInspector::ReadBinary(file, map) and map.m_block == blk_size and walk(map) == areas;
+        unlink(path);
+
+        HeapSummary live = HeapInspector::Summarize(p), read = HeapInspector::Summarize(map);
+        passed = passed and live.m_areas == read.m_areas and live.m_free_bytes == read.m_free_bytes and
+                 live.m_largest_free == read.m_largest_free and live.m_used_bytes + live.m_free_bytes == capacity;
+
+        failures += not passed;
+        std::cout << ">>> Testing a binary heap map round-trips (fragmentation " << live.Fragmentation() << ")... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        // The child writes while this process reads, so a map larger than the pipe's buffer goes through.
+        int ends[2];
+        bool passed = pipe(ends) == 0;
+        pid_t child = passed ? fork() : -1;
+        if (child == 0)
+        {
+            close(ends[0]);
+            bool written = HeapInspector::WriteBinary(p, blk_size, ends[1]);
+            close(ends[1]);
+            std::_Exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close(ends[1]);
+
+        std::string bytes;
+        char chunk[4096];
+        for (ssize_t n; (n = read(ends[0], chunk, sizeof(chunk))) > 0;)
+            bytes.append(chunk, n);
+        close(ends[0]);
+
+        int status(0);
+        passed = passed and child > 0 and waitpid(child, &status, 0) == child and WIFEXITED(status) and
+                 WEXITSTATUS(status) == EXIT_SUCCESS;
+
+        uint64_t n_areas(0u);
+        if (bytes.size() >= 32u)
+            std::memcpy(&n_areas, bytes.data() + 24, sizeof(n_areas));
+
+        HeapMap map;
+        std::istringstream stream(bytes);
+        passed = passed and n_areas == HeapInspector::UNCOUNTED and HeapInspector::ReadBinary(stream, map) and
+                 walk(map) == areas;
+
+        failures += not passed;
+        std::cout << ">>> Testing a binary heap map written to a pipe round-trips... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        std::ostringstream json;
+        HeapInspector::WriteJson(p, blk_size, json);
+        std::string text = json.str();
+
+        std::ostringstream last;
+        const char *base = static_cast<const char *>(areas.front().m_area);
+        last << '[' << static_cast<const char *>(areas.back().m_area) - base << ',' << areas.back().m_bytes << ',' << int(areas.back().m_free) << "]]";
+
+        const std::string head("{\"block\":16,\"areas\":[[");
+        bool passed = text.compare(0, head.size(), head) == 0 and
+                      size_t(std::count(text.begin(), text.end(), '[')) == areas.size() + 1u and
+                      text.find(last.str()) != std::string::npos;
+
+        failures += not passed;
+        std::cout << ">>> Testing the JSON heap map lists every area... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    for (auto area : reserved)
+        delete[] area;
+
+    {
+        // Four million blocks, one area out of two reserved.
+        const size_t n_areas(2u << 20);
+        SLPool<16> big(n_areas * 2 * blk_size);
+        std::vector<void *> held;
+        held.reserve(n_areas);
+        for (size_t i = 0; i < n_areas; ++i)
+            held.push_back(big.Allocate(blk_size));
+        // Downwards, so that each free lands at the head of the free list.
+        for (size_t i = n_areas; i >= 2; i -= 2)
+            big.Free(held[i - 2]);
+
+        auto start = std::chrono::steady_clock::now();
+        HeapSummary summary = HeapInspector::Summarize(big);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        bool passed = summary.m_areas >= n_areas and summary.m_free_areas >= n_areas / 2 and summary.m_free_areas <= n_areas / 2 + 1u;
+#ifdef NDEBUG
+        passed = passed and elapsed.count() < 200.0;
+#endif
+
+        // Upwards, so that each one merges into the head.
+        for (size_t i = 1; i < n_areas; i += 2)
+            big.Free(held[i]);
+
+        failures += not passed;
+        std::cout << ">>> Testing a walk of " << summary.m_areas << " areas takes " << elapsed.count() << " ms... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
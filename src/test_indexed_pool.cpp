@@ -0,0 +1,214 @@
+/**
+ * @file test_indexed_pool.cpp
+ *
+ * @description
+ * Test the IndexedPool against a reference best-fit allocator.
+ *
+ * 1) A single area corresponding to the entire pool can be reserved.
+ * 2) Random allocations and frees return the same areas as the reference (smallest
+ *    fit, lowest address among equals), and the free areas match it one by one.
+ * 3) Reserved areas keep their contents until they are freed.
+ * 4) The pool is a single free area again after everything has been freed.
+ */
+
+#include <iostream>
+#include <random>
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+#include "../include/mempool_common.h"
+#include "../include/IndexedPool.hpp"
+
+using namespace mp;
+
+using Pool = IndexedPool<16>;
+
+/// Reference best-fit allocator over block offsets.
+class Model
+{
+public:
+    explicit Model(size_t n_blocks) { this->Insert(0, n_blocks); }
+
+    /// Offset of the reserved area, or -1 when nothing fits.
+    long Allocate(size_t blocks)
+    {
+        auto best = m_by_size.lower_bound(std::make_pair(blocks, size_t(0)));
+        if (best == m_by_size.end())
+            return -1;
+
+        size_t length = best->first, offset = best->second;
+        this->Remove(offset);
+        if (length - blocks >= Pool::MIN_BLOCKS)
+            this->Insert(offset + blocks, length - blocks);
+        else
+            blocks = length;
+        m_reserved[offset] = blocks;
+
+        return long(offset);
+    }
+
+    void Free(size_t offset)
+    {
+        size_t blocks = m_reserved[offset];
+        m_reserved.erase(offset);
+
+        auto next = m_by_address.lower_bound(offset);
+        if (next != m_by_address.end() and offset + blocks == next->first)
+        {
+            blocks += next->second;
+            this->Remove(next->first);
+        }
+
+        next = m_by_address.lower_bound(offset);
+        if (next != m_by_address.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                blocks += prev->second;
+                this->Remove(offset);
+            }
+        }
+
+        this->Insert(offset, blocks);
+    }
+
+    const std::map<size_t, size_t> &FreeAreas() const { return m_by_address; }
+
+private:
+    void Insert(size_t offset, size_t blocks)
+    {
+        m_by_address[offset] = blocks;
+        m_by_size.insert(std::make_pair(blocks, offset));
+    }
+
+    void Remove(size_t offset)
+    {
+        m_by_size.erase(std::make_pair(m_by_address[offset], offset));
+        m_by_address.erase(offset);
+    }
+
+    std::map<size_t, size_t> m_by_address;
+    std::set<std::pair<size_t, size_t>> m_by_size;
+    std::map<size_t, size_t> m_reserved;
+};
+
+int main()
+{
+    const size_t pool_size(1u << 20);
+    const int n_ops(200000);
+    const size_t n_slots(600);
+    std::mt19937 g(2018);
+    auto failures(0);
+
+    std::cout << ">>> Begining INDEXED POOL tests...\n\n";
+
+    {
+        Pool p(pool_size);
+        bool passed(true);
+        try
+        {
+            p.Free(p.Allocate(pool_size));
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = false;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing the allocation of a single area with the entire pool... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    Pool p(pool_size);
+    char *base = nullptr;
+    p.ForEachFree([&base](const void *area, size_t) { base = (char *)area; });
+    Model model(pool_size / Pool::BLK_SZ + 1);
+
+    auto blocks = [](size_t bytes) { return std::max((bytes + Pool::HEADER_SZ + Pool::BLK_SZ - 1u) / Pool::BLK_SZ, Pool::MIN_BLOCKS); };
+    auto offset = [base](const char *ptr) { return size_t(ptr - Pool::HEADER_SZ - base) / Pool::BLK_SZ; };
+    auto same_free_areas = [&]() {
+        auto it = model.FreeAreas().begin(), end = model.FreeAreas().end();
+        bool same = p.FreeAreas() == model.FreeAreas().size();
+        p.ForEachFree([&](const void *area, size_t bytes) {
+            same = same and it != end and area == base + it->first * Pool::BLK_SZ and bytes == it->second * Pool::BLK_SZ;
+            if (it != end)
+                ++it;
+        });
+        return same;
+    };
+
+    struct Area
+    {
+        char *m_ptr = nullptr;
+        size_t m_bytes = 0u;
+        char m_fill = 0;
+    };
+    std::vector<Area> slots(n_slots);
+    bool same_areas(true), intact(true);
+
+    for (auto i(0); i < n_ops and same_areas and intact; ++i)
+    {
+        Area &area = slots[g() % n_slots];
+        if (area.m_ptr == nullptr)
+        {
+            size_t bytes = 1 + g() % (g() % 8 == 0 ? 8192 : 256);
+            area.m_ptr = (char *)p.Allocate(bytes, std::nothrow);
+            long expected = model.Allocate(blocks(bytes));
+            same_areas = expected < 0 ? area.m_ptr == nullptr : area.m_ptr == base + expected * Pool::BLK_SZ + Pool::HEADER_SZ;
+            if (area.m_ptr != nullptr)
+            {
+                area.m_bytes = bytes;
+                area.m_fill = char(i);
+                std::memset(area.m_ptr, area.m_fill, bytes);
+            }
+        }
+        else
+        {
+            for (size_t k = 0; k < area.m_bytes; ++k)
+                intact = intact and area.m_ptr[k] == area.m_fill;
+            p.Free(area.m_ptr);
+            model.Free(offset(area.m_ptr));
+            area = Area();
+        }
+
+        if (i % 256 == 0)
+            same_areas = same_areas and same_free_areas();
+    }
+
+    failures += not same_areas;
+    std::cout << ">>> Testing random operations against the best-fit reference... ";
+    std::cout << (same_areas ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+    failures += not intact;
+    std::cout << ">>> Testing reserved areas keep their contents... ";
+    std::cout << (intact ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+    for (auto &area : slots)
+        if (area.m_ptr != nullptr)
+            p.Free(area.m_ptr);
+
+    {
+        bool passed = p.FreeAreas() == 1u;
+        try
+        {
+            p.Free(p.Allocate(pool_size));
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = false;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing the pool is a single area after freeing everything... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <string>
 #include <sstream>
+#include <cstring>
 
 #include "../include/mempool_common.h"
 #include "../include/SLPool.hpp"
@@ -0,0 +1,237 @@
+/**
+ * @file test_maintained_pool.cpp
+ *
+ * @description
+ * Test the MaintainedPool, with and without its background maintenance worker.
+ *
+ * 1) Without a worker, the pool serves and frees areas on its own and is whole again afterwards.
+ * 2) Without a worker, freed areas are reused right away instead of the rest of the pool.
+ * 3) The worker merges deferred frees into the free list.
+ * 4) The worker refills the size caches ahead of demand, so that later requests hit them.
+ * 5) Once idle, the caches are emptied and the pages of the free areas go back to the OS.
+ * 6) Several threads allocating and freeing concurrently keep their data intact.
+ * 7) The worker stays within its CPU budget, which must be a fraction of a CPU.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <stdexcept>
+
+#include "../include/mempool_common.h"
+#include "../include/MaintainedPool.hpp"
+
+using namespace mp;
+
+using Pool = MaintainedPool<16>;
+
+/// Waits (up to two seconds) until `done()` holds.
+template <typename Predicate>
+bool eventually(Predicate done)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (not done() and std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return done();
+}
+
+/// Whether `p` can serve a single area of `bytes` bytes.
+bool whole(Pool &p, size_t bytes)
+{
+    void *ptr = p.Allocate(bytes, std::nothrow);
+    if (ptr == nullptr)
+        return false;
+    p.Free(ptr);
+    return true;
+}
+
+int main()
+{
+    const size_t pool_size(8u << 20);
+    const auto period = std::chrono::milliseconds(2);
+    auto failures(0);
+
+    std::cout << ">>> Begining MAINTAINED POOL tests...\n\n";
+
+    {
+        Pool p(pool_size);
+        std::vector<char *> areas;
+        for (auto i(0); i < 1000; ++i)
+        {
+            areas.push_back(new (p) char[1 + i % 300]);
+            std::memset(areas.back(), char(i), 1 + i % 300);
+        }
+        bool passed(true);
+        for (auto i(0); i < 1000; ++i)
+        {
+            for (auto k(0); k < 1 + i % 300; ++k)
+                passed = passed and areas[i][k] == char(i);
+            delete[] areas[i];
+        }
+        passed = passed and whole(p, pool_size);
+
+        failures += not passed;
+        std::cout << ">>> Testing the pool works without a worker... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        Pool p(1u << 20);
+        std::set<void *> addresses;
+        for (auto i(0); i < 100000; ++i)
+        {
+            void *ptr = p.Allocate(400);
+            addresses.insert(ptr);
+            p.Free(ptr);
+        }
+        bool passed = addresses.size() <= 2u;
+
+        failures += not passed;
+        std::cout << ">>> Testing freed areas are reused without a worker (" << addresses.size() << " addresses)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        Pool p(pool_size);
+        PoolMaintainer<Pool> worker(p, period);
+
+        std::vector<void *> areas;
+        for (auto i(0); i < 1000; ++i)
+            areas.push_back(p.Allocate(4096));
+        for (auto area : areas)
+            p.Free(area);
+
+        bool passed = eventually([&p] { return p.Stats().m_merged == 1000u; }) and
+                      eventually([&p] { return p.Stats().m_free_bytes + p.Stats().m_cached_bytes >= pool_size; });
+
+        failures += not passed;
+        std::cout << ">>> Testing the worker merges deferred frees... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        Pool p(pool_size);
+        PoolMaintainer<Pool> worker(p, period, 0.5, std::chrono::milliseconds(50));
+
+        // A steady demand for 48-byte areas...
+        bool passed(true);
+        size_t hits(0u);
+        for (auto round(0); round < 20; ++round)
+        {
+            std::vector<void *> areas;
+            for (auto i(0); i < 100; ++i)
+                areas.push_back(p.Allocate(48));
+            for (auto area : areas)
+                p.Free(area);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        // ... is served from the cache once the worker has seen it.
+        passed = eventually([&p, &hits] { return (hits = p.Stats().m_cache_hits) > 1000u; }) and p.Stats().m_recycled > 0u;
+
+        failures += not passed;
+        std::cout << ">>> Testing the worker refills the size caches (" << hits << " hits out of 2000)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        // Then the pool goes idle.
+        passed = eventually([&p] { return p.Stats().m_cached_bytes == 0u and p.Stats().m_released > 0u; });
+
+        failures += not passed;
+        std::cout << ">>> Testing an idle pool is emptied and trimmed... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        Pool p(pool_size);
+        PoolMaintainer<Pool> worker(p, period);
+        const int n_threads(4);
+        std::vector<int> intact(n_threads, 1);
+        std::vector<std::thread> threads;
+
+        for (auto t(0); t < n_threads; ++t)
+            threads.emplace_back([&p, &intact, t] {
+                std::mt19937 g(t);
+                std::vector<std::pair<char *, size_t>> live;
+                for (auto i(0); i < 50000; ++i)
+                {
+                    if (live.size() < 64 and g() % 2 == 0)
+                    {
+                        size_t bytes = 1 + g() % 200;
+                        char *area = new (p) char[bytes];
+                        std::memset(area, char(t), bytes);
+                        live.push_back(std::make_pair(area, bytes));
+                    }
+                    else if (not live.empty())
+                    {
+                        auto area = live.back();
+                        live.pop_back();
+                        for (size_t k = 0; k < area.second; ++k)
+                            intact[t] = intact[t] and area.first[k] == char(t);
+                        delete[] area.first;
+                    }
+                }
+                for (auto area : live)
+                    delete[] area.first;
+            });
+        for (auto &thread : threads)
+            thread.join();
+
+        bool passed = std::count(intact.begin(), intact.end(), 1) == n_threads and whole(p, pool_size);
+
+        failures += not passed;
+        std::cout << ">>> Testing concurrent threads with the worker running... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        std::vector<std::unique_ptr<Pool>> owned;
+        std::vector<Pool *> pools;
+        for (auto i(0); i < 8; ++i)
+        {
+            owned.emplace_back(new Pool(1u << 20));
+            pools.push_back(owned.back().get());
+        }
+
+        const double budget(0.02);
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds cpu;
+        {
+            PoolMaintainer<Pool> worker(pools, std::chrono::milliseconds(0), budget);
+            for (auto round(0); round < 200; ++round)
+            {
+                for (auto pool : pools)
+                    pool->Free(pool->Allocate(32));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            cpu = worker.CpuTime();
+        }
+        std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+        std::chrono::duration<double> used = cpu;
+
+        // One pass may overshoot before the worker backs off.
+        bool passed = used.count() <= 2 * budget * wall.count() + 0.005;
+
+        for (double wrong : {0.0, -0.5, 1.5})
+        {
+            try
+            {
+                PoolMaintainer<Pool> worker(*pools.front(), std::chrono::milliseconds(10), wrong);
+                passed = false;
+            }
+            catch (std::invalid_argument &e)
+            {
+            }
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing the worker stays within its CPU budget (" << 100 * used.count() / wall.count() << "% of a CPU)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
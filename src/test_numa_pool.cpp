@@ -0,0 +1,222 @@
+/**
+ * @file test_numa_pool.cpp
+ *
+ * @description
+ * Test the NUMA-aware pool set, on any machine.
+ *
+ * 1) Kernel node lists ("0-3,8,10-11") are parsed correctly.
+ * 2) The topology of this machine has at least one node, and every CPU maps to one of them.
+ * 3) A fake two-node /sys tree gives two arenas, and allocations go to the node of the caller.
+ * 4) A full arena spills over to the other node, and frees go back to the owning arena.
+ * 5) A machine without /sys/devices/system/node degrades to a single arena.
+ * 6) Pointers from elsewhere belong to no node, and freeing one is refused.
+ * 7) A set whose last arena can't be mapped unmaps the arenas it already had.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "../include/mempool_common.h"
+#include "../include/NumaPoolSet.hpp"
+
+using namespace mp;
+
+/// Writes a fake /sys/devices/system/node with nodes 0 and 1; every CPU of this machine goes to `local`.
+std::string fake_topology(char *root, int local)
+{
+    const long n_cpus = sysconf(_SC_NPROCESSORS_CONF);
+    std::string cpus = "0-" + std::to_string(n_cpus - 1);
+
+    for (auto node(0); node < 2; ++node)
+    {
+        std::string dir = std::string(root) + "/node" + std::to_string(node);
+        mkdir(dir.c_str(), 0700);
+        std::ofstream(dir + "/cpulist") << (node == local ? cpus : std::string("")) << "\n";
+    }
+    std::ofstream(std::string(root) + "/online") << "0-1\n";
+
+    return root;
+}
+
+/// Bytes of address space of this process.
+size_t address_space()
+{
+    size_t pages(0);
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages;
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+void remove_topology(const std::string &root)
+{
+    for (auto node(0); node < 2; ++node)
+    {
+        std::string dir = root + "/node" + std::to_string(node);
+        unlink((dir + "/cpulist").c_str());
+        rmdir(dir.c_str());
+    }
+    unlink((root + "/online").c_str());
+    rmdir(root.c_str());
+}
+
+int main()
+{
+    const size_t arena_size(1u << 20);
+    auto failures(0);
+
+    std::cout << ">>> Begining NUMA POOL tests...\n\n";
+
+    {
+        bool passed = NumaTopology::ParseList("0-3,8,10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}) and
+                      NumaTopology::ParseList("0") == std::vector<int>({0}) and NumaTopology::ParseList("").empty();
+
+        failures += not passed;
+        std::cout << ">>> Testing the kernel list parser... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        NumaTopology topology = NumaTopology::Detect();
+        bool passed = not topology.m_nodes.empty();
+        for (size_t node : topology.m_cpus)
+            passed = passed and node < topology.m_nodes.size();
+
+        NumaPoolSet<16> set(arena_size, topology);
+        void *ptr = set.Allocate(1000);
+        passed = passed and set.NodeOf(ptr) == int(set.CurrentNode());
+        set.Free(ptr);
+
+        failures += not passed;
+        std::cout << ">>> Testing the topology of this machine (" << topology.m_nodes.size() << " node(s))... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    char dir[] = "/tmp/gremlins_numaXXXXXX";
+    if (mkdtemp(dir) == nullptr)
+    {
+        std::cout << ">>> Could not create a fake topology: " << std::strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string root = fake_topology(dir, 1);
+
+    {
+        NumaPoolSet<16> set(arena_size, NumaTopology::Detect(root));
+        bool passed = set.Nodes() == std::vector<int>({0, 1}) and set.CurrentNode() == 1u;
+
+        std::vector<int *> objects;
+        for (auto i(0); i < 100; ++i)
+        {
+            objects.push_back(new (set) int(i));
+            passed = passed and set.NodeOf(objects.back()) == 1;
+        }
+        for (auto object : objects)
+            delete object;
+
+        failures += not passed;
+        std::cout << ">>> Testing allocations go to the node of the caller... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        NumaPoolSet<16> set(arena_size, NumaTopology::Detect(root));
+
+        // Fill node 1, then the next allocation has to come from node 0.
+        void *local = set.Allocate(arena_size);
+        void *spilled = set.Allocate(arena_size / 2);
+        bool passed = set.NodeOf(local) == 1 and set.NodeOf(spilled) == 0;
+
+        // Free the spilled area from this (node 1) thread: node 0 must be whole again.
+        set.Free(spilled);
+        set.Free(local);
+        void *whole0 = set.AllocateOn(0, arena_size);
+        void *whole1 = set.AllocateOn(1, arena_size);
+        passed = passed and whole0 != nullptr and whole1 != nullptr and set.NodeOf(whole0) == 0 and set.NodeOf(whole1) == 1;
+        passed = passed and set.Allocate(arena_size / 2, std::nothrow) == nullptr;
+        set.Free(whole0);
+        set.Free(whole1);
+
+        failures += not passed;
+        std::cout << ">>> Testing spill-over and frees back to the owning arena... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    remove_topology(root);
+
+    {
+        NumaPoolSet<16> set(arena_size, NumaTopology::Detect(root));
+        bool passed = set.Nodes().size() == 1u and set.CurrentNode() == 0u and not set.Bound(0);
+
+        void *ptr = set.Allocate(arena_size);
+        passed = passed and set.NodeOf(ptr) == 0;
+        set.Free(ptr);
+
+        failures += not passed;
+        std::cout << ">>> Testing a machine without NUMA information gets a single arena... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        NumaPoolSet<16> set(arena_size);
+        int local(0);
+        int *heap = new int(0);
+        bool passed = set.NodeOf(&local) == -1 and set.NodeOf(heap) == -1 and set.NodeOf(nullptr) == -1;
+
+        try
+        {
+            set.Free(heap);
+            passed = false;
+        }
+        catch (std::invalid_argument &e)
+        {
+        }
+        delete heap;
+
+        // The set must still be whole.
+        void *ptr = set.Allocate(arena_size, std::nothrow);
+        passed = passed and ptr != nullptr;
+        set.Free(ptr);
+
+        failures += not passed;
+        std::cout << ">>> Testing pointers from elsewhere are refused... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        // Room for two arenas out of four.
+        NumaTopology topology;
+        topology.m_nodes = {0, 1, 2, 3};
+
+        struct rlimit saved, limit;
+        getrlimit(RLIMIT_AS, &saved);
+        const size_t before(address_space());
+        limit = saved;
+        limit.rlim_cur = before + 2 * arena_size + arena_size / 2;
+        bool passed = setrlimit(RLIMIT_AS, &limit) == 0;
+
+        try
+        {
+            NumaPoolSet<16> set(arena_size, topology);
+            passed = false;
+        }
+        catch (std::bad_alloc &e)
+        {
+        }
+        setrlimit(RLIMIT_AS, &saved);
+        passed = passed and address_space() < before + arena_size;
+
+        failures += not passed;
+        std::cout << ">>> Testing a failed construction unmaps the arenas already mapped... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file test_pool_promise.cpp
+ *
+ * @description
+ * Test that PoolPromise takes coroutine frames from GREMLINS pools (C++20).
+ *
+ * 1) A coroutine that is passed a pool gets its frame from it, and gives it back when destroyed.
+ * 2) So does a member coroutine that is passed a pool.
+ * 3) Parameters taken by value are neither copied by nor lost to the frame allocation, move-only ones included.
+ * 4) Other coroutines get their frames from a size class of FramePool(); frames too large for it come from the heap.
+ * 5) Frames created on one thread can be resumed and destroyed on another.
+ * 6) The size class is whole again once those frames are gone.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <coroutine>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/mempool_common.h"
+#include "../include/BitmapPool.hpp"
+#include "../include/PoolPromise.hpp"
+
+using namespace mp;
+
+/// Generator of longs that exposes its frame.
+class Generator
+{
+public:
+    struct promise_type : PoolPromise
+    {
+        long m_value = 0;
+
+        Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(long value)
+        {
+            m_value = value;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Generator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+    Generator(Generator &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    ~Generator()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool Next()
+    {
+        m_handle.resume();
+        return not m_handle.done();
+    }
+    long Value() const { return m_handle.promise().m_value; }
+
+    /// Pool the frame came from (nullptr: the heap).
+    StoragePool *Pool() const { return TagOf(m_handle.address())->pool; }
+
+    /// Sum of the remaining values.
+    long Drain()
+    {
+        long sum = 0;
+        while (this->Next())
+            sum += this->Value();
+        return sum;
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+Generator count(StoragePool &, long n)
+{
+    for (long i = 0; i < n; ++i)
+        co_yield i;
+}
+
+Generator count(long n)
+{
+    for (long i = 0; i < n; ++i)
+        co_yield i;
+}
+
+/// Keeps a large array alive across suspensions: its frame fits no size class.
+Generator count_large(long n)
+{
+    char scratch[4096];
+    std::memset(scratch, 1, sizeof(scratch));
+    for (long i = 0; i < n; ++i)
+        co_yield i + scratch[i % sizeof(scratch)] - 1;
+}
+
+/// Counts its copies.
+struct Copies
+{
+    static int s_count;
+
+    Copies() = default;
+    Copies(const Copies &) { ++s_count; }
+    Copies(Copies &&) = default;
+};
+int Copies::s_count = 0;
+
+Generator count_owned(StoragePool &, Copies, std::unique_ptr<long> n)
+{
+    for (long i = 0; i < *n; ++i)
+        co_yield i;
+}
+
+struct Counter
+{
+    long m_step;
+
+    Generator count(StoragePool &, long n)
+    {
+        for (long i = 0; i < n; ++i)
+            co_yield i * m_step;
+    }
+};
+
+/// Size of the blocks of FramePool() class `pool`, or 0 if it's none of them.
+size_t class_size(StoragePool *pool)
+{
+    for (size_t size : {128u, 256u, 512u, 1024u})
+        if (pool == FramePool(size - sizeof(Tag)))
+            return size;
+    return 0u;
+}
+
+/// Whether every slot of a FramePool() class is free: the owner reserves them all, then frees them.
+bool whole(StoragePool *pool, size_t size)
+{
+    std::vector<void *> slots;
+    for (void *slot; (slot = pool->Allocate(size - sizeof(Tag), std::nothrow)) != nullptr;)
+        slots.push_back(slot);
+    for (void *slot : slots)
+        pool->Free(slot);
+
+    return slots.size() == FRAME_CLASS_SZ / size;
+}
+
+int main()
+{
+    const long n(100);
+    const long sum(n * (n - 1) / 2);
+    auto failures(0);
+
+    std::cout << ">>> Begining POOL PROMISE tests...\n\n";
+
+    {
+        BitmapPool<256> p(256 * 8);
+        bool passed(true);
+        {
+            Generator generator = count(p, n);
+            passed = generator.Pool() == &p and p.Reserved() == 1u and generator.Drain() == sum;
+        }
+        passed = passed and p.Reserved() == 0u;
+
+        failures += not passed;
+        std::cout << ">>> Testing frames from the pool passed to the coroutine... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        BitmapPool<256> p(256 * 8);
+        Counter counter{2};
+        bool passed(true);
+        {
+            Generator generator = counter.count(p, n);
+            passed = generator.Pool() == &p and p.Reserved() == 1u and generator.Drain() == 2 * sum;
+        }
+        passed = passed and p.Reserved() == 0u;
+
+        failures += not passed;
+        std::cout << ">>> Testing frames from the pool passed to a member coroutine... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        BitmapPool<256> p(256 * 8);
+        bool passed(true);
+        {
+            Generator generator = count_owned(p, Copies(), std::unique_ptr<long>(new long(n)));
+            passed = generator.Pool() == &p and Copies::s_count == 0 and generator.Drain() == sum;
+        }
+        passed = passed and p.Reserved() == 0u;
+
+        failures += not passed;
+        std::cout << ">>> Testing parameters taken by value, move-only ones included... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        Generator generator = count(n);
+        Generator large = count_large(n);
+        bool passed = class_size(generator.Pool()) != 0u and large.Pool() == nullptr and generator.Drain() == sum and
+                      large.Drain() == sum;
+
+        failures += not passed;
+        std::cout << ">>> Testing frames from FramePool() (" << class_size(generator.Pool()) << "-byte class) or the heap... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        const size_t n_frames(1000);
+        std::vector<Generator> generators;
+        StoragePool *pool(nullptr);
+        std::atomic<bool> filled(false), destroyed(false);
+        bool intact(true), whole_again(false);
+
+        // The frames come from the classes of the creating thread...
+        std::thread creator([&]() {
+            for (auto i(0u); i < n_frames; ++i)
+                generators.push_back(count(n));
+            pool = generators.front().Pool();
+            filled = true;
+            while (not destroyed)
+                std::this_thread::yield();
+
+            // ... which takes them back through the remote-free stack on its next allocation.
+            whole_again = whole(pool, class_size(pool));
+        });
+
+        // Run and destroy them on this thread.
+        while (not filled)
+            std::this_thread::yield();
+        for (auto &generator : generators)
+            intact = intact and generator.Pool() == pool and generator.Drain() == sum;
+        generators.clear();
+        destroyed = true;
+        creator.join();
+
+        failures += not intact;
+        std::cout << ">>> Testing frames resumed and destroyed on another thread... ";
+        std::cout << (intact ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        failures += not whole_again;
+        std::cout << ">>> Testing the size class is whole again afterwards... ";
+        std::cout << (whole_again ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file test_pool_scope.cpp
+ *
+ * @description
+ * Test the per-thread pool scope of plain new/new[].
+ *
+ * 1) Outside any scope, plain new goes to the default heap.
+ * 2) Inside a scope, new and new[] are served from the chosen pool.
+ * 3) Scopes nest, and leaving one restores the enclosing pool.
+ * 4) Areas deleted after their scope ended go back to their own pool.
+ * 5) Other threads are not affected by a scope.
+ * 6) (C++17) The pmr default resource follows the scope as well.
+ */
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+
+using namespace mp;
+
+/// Pool recorded in the Tag of an area returned by new.
+/// (Not inlined: the compiler would see a read before the object and may drop the new/delete pair.)
+__attribute__((noinline)) StoragePool *owner(const void *ptr)
+{
+    asm volatile("" : "+r"(ptr));
+    return (reinterpret_cast<const Tag *>(ptr) - 1U)->pool;
+}
+
+/// Whether `p` can serve a single area of `bytes` bytes, i.e. nothing of it is still reserved.
+bool whole(SLPool<16> &p, size_t bytes)
+{
+    try
+    {
+        p.Free(p.Allocate(bytes));
+        return true;
+    }
+    catch (std::bad_alloc &e)
+    {
+        return false;
+    }
+}
+
+int main()
+{
+    const size_t pool_size(1u << 20);
+    SLPool<16> outer(pool_size), inner(pool_size);
+    auto failures(0);
+
+    std::cout << ">>> Begining POOL SCOPE tests...\n\n";
+
+    {
+        int *heap = new int(1);
+        bool passed = owner(heap) == nullptr and CurrentPool() == nullptr;
+        delete heap;
+
+        failures += not passed;
+        std::cout << ">>> Testing new outside a scope goes to the heap... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    int *survivor;
+    {
+        bool passed;
+        {
+            PoolScope scope(outer);
+            int *single = new int(2);
+            double *array = new double[100];
+            std::vector<int> *vector = new std::vector<int>(1000, 3);
+            passed = owner(single) == &outer and owner(array) == &outer and owner(vector) == &outer and
+                     owner(vector->data()) == &outer;
+            delete single;
+            delete[] array;
+            delete vector;
+            survivor = new int(4);
+        }
+        passed = passed and CurrentPool() == nullptr;
+
+        failures += not passed;
+        std::cout << ">>> Testing new and new[] inside a scope go to its pool... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed;
+        {
+            PoolScope a(outer);
+            std::string *before = new std::string(100, 'a');
+            bool nested;
+            {
+                PoolScope b(inner);
+                std::string *within = new std::string(100, 'b');
+                nested = owner(within) == &inner and owner(&(*within)[0]) == &inner;
+                delete within;
+            }
+            std::string *after = new std::string(100, 'c');
+            passed = nested and owner(before) == &outer and owner(after) == &outer and CurrentPool() == &outer;
+            delete before;
+            delete after;
+        }
+        passed = passed and whole(inner, pool_size);
+
+        failures += not passed;
+        std::cout << ">>> Testing nested scopes restore the enclosing pool... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed = *survivor == 4 and owner(survivor) == &outer and not whole(outer, pool_size);
+        delete survivor;
+        passed = passed and whole(outer, pool_size);
+
+        failures += not passed;
+        std::cout << ">>> Testing areas deleted after their scope go back to their pool... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed(false);
+        std::thread other;
+        {
+            PoolScope scope(outer);
+            // The launch state of the thread comes from `outer` (and goes back to it from the new
+            // thread), but what the thread itself allocates must not.
+            other = std::thread([&passed] { int *ptr = new int(5); passed = owner(ptr) == nullptr and CurrentPool() == nullptr; delete ptr; });
+        }
+        other.join();
+        passed = passed and whole(outer, pool_size);
+
+        failures += not passed;
+        std::cout << ">>> Testing other threads are not affected by a scope... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+#ifdef MP_HAS_PMR
+    {
+        bool passed;
+        {
+            PoolScope scope(outer);
+            std::pmr::vector<int> numbers(1000, 6);
+            std::pmr::string text(200, 'd');
+            passed = owner(numbers.data()) == &outer and owner(text.data()) == &outer;
+        }
+        std::pmr::vector<int> outside(1000, 7);
+        passed = passed and owner(outside.data()) == nullptr and whole(outer, pool_size);
+
+        failures += not passed;
+        std::cout << ">>> Testing the pmr default resource follows the scope... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+#endif
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test_preload.cpp
+ *
+ * @description
+ * Test the malloc interposition library. Run it with
+ *
+ *     LD_PRELOAD=./bin/libgremlins_preload.so ./bin/test_preload
+ *
+ * (ctest does so).
+ *
+ * 1) malloc and friends are the library's.
+ * 2) Areas of every size keep their contents, and calloc zeroes them.
+ * 3) Requests too large to pad with a header fail with ENOMEM instead of wrapping around.
+ * 4) posix_memalign rejects alignments that are 0, not a power of two or not a multiple of sizeof(void *).
+ * 5) Over-aligned requests are aligned.
+ */
+
+#include <iostream>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <malloc.h>
+
+/// Whether the `name` the program calls comes from the interposition library.
+bool interposed(const char *name)
+{
+    Dl_info info;
+    void *symbol = dlsym(RTLD_DEFAULT, name);
+    return symbol != nullptr and dladdr(symbol, &info) != 0 and info.dli_fname != nullptr and
+           std::strstr(info.dli_fname, "gremlins_preload") != nullptr;
+}
+
+/// Whether `ptr` is null and errno tells why.
+bool refused(void *ptr)
+{
+    bool passed = ptr == nullptr and errno == ENOMEM;
+    free(ptr);
+    errno = 0;
+    return passed;
+}
+
+int main()
+{
+    // Volatile, so that the compiler neither folds the sizes nor warns about them.
+    volatile size_t huge = SIZE_MAX;
+    auto failures(0);
+
+    std::cout << ">>> Begining PRELOAD tests...\n\n";
+
+    {
+        bool passed = interposed("malloc") and interposed("free") and interposed("calloc") and
+                      interposed("realloc") and interposed("posix_memalign") and interposed("aligned_alloc");
+
+        failures += not passed;
+        std::cout << ">>> Testing malloc and friends are interposed... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+        if (not passed)
+            return EXIT_FAILURE;
+    }
+
+    {
+        bool passed(true);
+        // Arena areas and areas with a mapping of their own.
+        for (size_t bytes : {size_t(1), size_t(100), size_t(4000), size_t(1) << 20, size_t(3) << 20})
+        {
+            char *area = static_cast<char *>(malloc(bytes));
+            std::memset(area, 'x', bytes);
+            area = static_cast<char *>(realloc(area, 2 * bytes));
+            passed = passed and area[0] == 'x' and area[bytes - 1] == 'x' and malloc_usable_size(area) >= 2 * bytes;
+            free(area);
+
+            unsigned char *zeroed = static_cast<unsigned char *>(calloc(bytes, 1));
+            for (size_t i = 0; i < bytes and passed; ++i)
+                passed = zeroed[i] == 0u;
+            std::memset(zeroed, 0xff, bytes);
+            free(zeroed);
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing areas keep their contents... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        void *ptr = nullptr;
+        bool passed = refused(malloc(huge)) and refused(malloc(huge - 8)) and refused(malloc(huge - 4096)) and
+                      refused(realloc(nullptr, huge - 8)) and refused(calloc(huge / 2, 3)) and
+                      refused(calloc(2, huge / 2 + 1)) and refused(aligned_alloc(64, huge - 16)) and
+                      refused(memalign(4096, huge - 4096)) and refused(valloc(huge)) and refused(pvalloc(huge - 1)) and
+                      posix_memalign(&ptr, 64, huge - 32) == ENOMEM and ptr == nullptr;
+
+        void *area = malloc(16);
+        passed = passed and refused(realloc(area, huge - 8));
+        free(area);
+
+        failures += not passed;
+        std::cout << ">>> Testing oversized requests fail with ENOMEM... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        void *ptr = nullptr;
+        bool passed = posix_memalign(&ptr, 0, 16) == EINVAL and posix_memalign(&ptr, 24, 16) == EINVAL and
+                      posix_memalign(&ptr, sizeof(void *) / 2, 16) == EINVAL and ptr == nullptr;
+
+        failures += not passed;
+        std::cout << ">>> Testing posix_memalign rejects bad alignments... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed(true);
+        for (size_t alignment = sizeof(void *); alignment <= 8192; alignment *= 2)
+        {
+            void *ptr = nullptr;
+            passed = passed and posix_memalign(&ptr, alignment, 100) == 0 and reinterpret_cast<uintptr_t>(ptr) % alignment == 0u;
+            std::memset(ptr, 'y', 100);
+            free(ptr);
+
+            void *other = aligned_alloc(alignment, 3u << 20);
+            passed = passed and other != nullptr and reinterpret_cast<uintptr_t>(other) % alignment == 0u;
+            free(other);
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing over-aligned requests... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file test_remote_free.cpp
+ *
+ * @description
+ * Test the RemoteFreePool with several threads freeing into a single owner.
+ *
+ * 1) Areas handed to other threads reach them intact.
+ * 2) Every area freed by another thread is drained by the owner exactly once.
+ * 3) Areas the owner kept, next to the drained ones, keep their contents.
+ * 4) The pool is a single free area again after everything has been freed.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+#include "../include/mempool_common.h"
+#include "../include/RemoteFreePool.hpp"
+
+using namespace mp;
+
+using byte = char;
+
+struct Area
+{
+    byte *m_ptr;
+    size_t m_len;
+    byte m_fill;
+};
+
+bool intact(const Area &area)
+{
+    for (auto i(0u); i < area.m_len; ++i)
+        if (area.m_ptr[i] != area.m_fill)
+            return false;
+    return true;
+}
+
+int main()
+{
+    const size_t pool_size(8u << 20); // 8 MiB
+    const size_t n_producers(4);
+    const size_t per_producer(5000);
+    auto failures(0);
+
+    std::cout << ">>> Begining REMOTE FREE tests...\n\n";
+
+    RemoteFreePool<16> p(pool_size);
+
+    // Every other area goes to a producer; the owner keeps the ones in between.
+    std::vector<std::vector<Area>> handed(n_producers);
+    std::vector<Area> kept;
+    for (auto i(0u); i < 2 * n_producers * per_producer; ++i)
+    {
+        Area area{nullptr, 1 + i % 100, byte('a' + i % 26)};
+        area.m_ptr = new (p) byte[area.m_len];
+        std::memset(area.m_ptr, area.m_fill, area.m_len);
+        if (i % 2 == 0)
+            handed[(i / 2) % n_producers].push_back(area);
+        else
+            kept.push_back(area);
+    }
+
+    std::atomic<bool> go(false);
+    std::atomic<size_t> running(n_producers), damaged(0);
+    std::vector<std::thread> producers;
+    for (auto t(0u); t < n_producers; ++t)
+        producers.emplace_back([&, t]() {
+            while (not go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            for (auto &area : handed[t])
+            {
+                damaged += not intact(area);
+                delete[] area.m_ptr;
+            }
+            --running;
+        });
+
+    // Drain while the producers free.
+    size_t drained(0);
+    go.store(true, std::memory_order_release);
+    while (running.load() > 0u)
+    {
+        drained += p.Drain();
+        std::this_thread::yield();
+    }
+    for (auto &producer : producers)
+        producer.join();
+    drained += p.Drain();
+
+    {
+        bool passed = damaged.load() == 0u;
+        failures += not passed;
+        std::cout << ">>> Testing areas reach the other threads intact... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed = drained == n_producers * per_producer and p.Drain() == 0u;
+        failures += not passed;
+        std::cout << ">>> Testing every remote free is drained once (" << drained << " areas)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        bool passed(true);
+        for (auto &area : kept)
+            passed = passed and intact(area);
+
+        failures += not passed;
+        std::cout << ">>> Testing the owner's areas keep their contents... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    for (auto &area : kept)
+        delete[] area.m_ptr;
+
+    {
+        bool passed(true);
+        try
+        {
+            p.Free(p.Allocate(pool_size));
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = false;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing the pool is a single area after freeing everything... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_static_pool.cpp
+ *
+ * @description
+ * Test the heap-free, constant-initialized StaticSLPool.
+ *
+ * 1) A pool at namespace scope can be used by dynamic initializers that run before its definition.
+ * 2) A single area may span the entire pool.
+ * 3) Data integrity after freeing and reallocating interleaved areas.
+ * 4) A pool's storage takes no room in the executable: it is in .bss.
+ * 5) A second pool of the same type can't allocate until the first one is gone: it asserts (or fails,
+ *    with assertions off). Once the first pool is gone, the storage is whole again for the next one.
+ */
+
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "../include/mempool_common.h"
+#include "../include/StaticSLPool.hpp"
+
+using namespace mp;
+
+const short BLOCK_SIZE = 24;
+using byte = char;
+const short n_blocks(2);
+const short chunk(n_blocks * BLOCK_SIZE);
+const short area_metainfo(mp::SLPool<BLOCK_SIZE>::TAG_SZ + mp::SLPool<BLOCK_SIZE>::HEADER_SZ);
+const short n_chunks(7);
+const size_t chunk_len(2 * BLOCK_SIZE - area_metainfo);
+
+template <typename TAG>
+using TaggedPool = mp::StaticSLPool<BLOCK_SIZE, chunk * n_chunks - area_metainfo, TAG>;
+typedef TaggedPool<struct Global> Pool;
+
+extern Pool g_pool;
+
+/// Reserves an area from g_pool while the program is still being initialized.
+struct EarlyUser
+{
+    byte *m_area;
+
+    EarlyUser() : m_area(new (g_pool) byte[chunk_len])
+    {
+        std::strcpy(m_area, "early");
+    }
+};
+
+// Defined before the pool: had the pool a dynamic initializer, it would run after this one.
+EarlyUser g_early;
+Pool g_pool;
+
+// Large enough to show up in the size of the executable, had it been in .data.
+const size_t big_len(16u << 20);
+StaticSLPool<16, big_len, struct Big> g_big;
+
+// Set by the linker (GNU ld, gold and lld alike).
+extern "C" char __bss_start[], _end[];
+
+int main()
+{
+    auto failures(0);
+
+    std::cout << ">>> Begining STATIC POOL tests...\n\n";
+
+    {
+        byte *late = new (g_pool) byte[chunk_len];
+        std::strcpy(late, "late");
+
+        bool passed = late != g_early.m_area and std::strcmp(g_early.m_area, "early") == 0 and std::strcmp(late, "late") == 0;
+        failures += not passed;
+        std::cout << ">>> Testing pool use before its definition in the translation unit... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        delete[] late;
+        delete[] g_early.m_area;
+    }
+
+    {
+        static TaggedPool<struct Whole> p;
+
+        bool passed(true);
+        try
+        {
+            byte *whole = new (p) byte[n_chunks * chunk - area_metainfo];
+            delete[] whole;
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = false;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Allocating a single area with length equal to the entire pool size... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        TaggedPool<struct Interleaved> p; // On the stack, this time (its storage is still static).
+        byte *vet[n_chunks];
+
+        std::ostringstream oss;
+        auto j(0u);
+        while (j < chunk_len - 1) // Remember we have to reserve one extra space for the '\0'.
+            oss << (j++ % 10);
+        std::string reference_a(oss.str());
+        std::string reference_b(reference_a.rbegin(), reference_a.rend());
+
+        for (auto i(0); i < n_chunks; ++i)
+        {
+            vet[i] = new (p) byte[chunk_len];
+            strcpy(vet[i], reference_a.c_str());
+        }
+
+        for (auto i(1); i < n_chunks; i += 2)
+            delete[] vet[i];
+
+        for (auto i(1); i < n_chunks; i += 2)
+        {
+            vet[i] = new (p) byte[chunk_len];
+            strcpy(vet[i], reference_b.c_str());
+        }
+
+        bool passed(true);
+        for (auto i(0); i < n_chunks and passed; ++i)
+            passed = strcmp((i % 2 == 0 ? reference_a : reference_b).c_str(), vet[i]) == 0;
+
+        // The pool must be full now.
+        try
+        {
+            new (p) byte[1];
+            passed = false;
+        }
+        catch (std::bad_alloc &e)
+        {
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing pool integrity after deleting and realocating interleaved areas... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        byte *area = new (g_big) byte[big_len];
+        struct stat exe;
+        bool passed = area >= __bss_start and area + big_len <= _end and stat("/proc/self/exe", &exe) == 0 and
+                      size_t(exe.st_size) < big_len / 4;
+        delete[] area;
+
+        failures += not passed;
+        std::cout << ">>> Testing storage is in .bss (executable of " << exe.st_size / 1024 << " KiB)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        // In a child, since the second pool aborts the program when assertions are on.
+        pid_t child = fork();
+        if (child == 0)
+        {
+            TaggedPool<struct Shared> first, second;
+            byte *area = new (first) byte[chunk_len];
+            bool refused = second.Allocate(1, std::nothrow) == nullptr;
+            delete[] area;
+            std::_Exit(refused ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        int status(0);
+        bool passed = child > 0 and waitpid(child, &status, 0) == child and
+                      ((WIFEXITED(status) and WEXITSTATUS(status) == EXIT_SUCCESS) or
+                       (WIFSIGNALED(status) and WTERMSIG(status) == SIGABRT));
+        {
+            TaggedPool<struct Shared> third; // The storage is free again.
+            try
+            {
+                delete[] new (third) byte[n_chunks * chunk - area_metainfo];
+            }
+            catch (std::bad_alloc &e)
+            {
+                passed = false;
+            }
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing pools of the same type take turns on their storage... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
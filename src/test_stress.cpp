@@ -0,0 +1,350 @@
+/**
+ * @file test_stress.cpp
+ *
+ * @description
+ * Randomized stress and differential test of SLPool, with throughput gates.
+ *
+ * 1) Millions of random allocate/free/reallocate operations are replayed on an SLPool
+ *    and on a reference first-fit allocator (a std::map of free areas written the
+ *    obvious way). Every returned address must match the reference, the free list
+ *    must match it area by area (so a missed coalescing shows up at once), and every
+ *    reserved area must keep the bytes written into it until it is freed.
+ * 2) The same workloads are timed without the checks, and the throughput must stay
+ *    above the thresholds listed in the baseline file (only in optimised builds).
+ *
+ * Usage: test_stress [baseline file] [operations per workload]
+ *
+ * The baseline file lists one `workload  minimum_Mops_per_second` pair per line;
+ * lines starting with '#' are comments.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+
+using namespace mp;
+
+using Pool = SLPool<16>;
+
+/// Reference allocator: first fit over a std::map of free areas (offset -> length, in blocks).
+class Model
+{
+public:
+    explicit Model(size_t n_blocks)
+    {
+        m_free[0] = n_blocks - 1; // The last block is the sentinel.
+    }
+
+    /// Offset of the reserved area, or -1 when nothing fits.
+    long Allocate(size_t blocks)
+    {
+        for (auto it = m_free.begin(); it != m_free.end(); ++it)
+            if (it->second >= blocks)
+            {
+                size_t offset = it->first, length = it->second;
+                m_free.erase(it);
+                if (length > blocks)
+                    m_free[offset + blocks] = length - blocks;
+                return long(offset);
+            }
+
+        return -1;
+    }
+
+    void Free(size_t offset, size_t blocks)
+    {
+        auto next = m_free.lower_bound(offset);
+        if (next != m_free.end() and offset + blocks == next->first)
+        {
+            blocks += next->second;
+            next = m_free.erase(next);
+        }
+
+        if (next != m_free.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += blocks;
+                return;
+            }
+        }
+
+        m_free[offset] = blocks;
+    }
+
+    const std::map<size_t, size_t> &FreeAreas() const { return m_free; }
+
+private:
+    std::map<size_t, size_t> m_free;
+};
+
+/// Size distribution and live-set bound of a workload.
+struct Workload
+{
+    const char *m_name;
+    size_t m_pool_bytes; //!< Size of the pool.
+    size_t m_slots;      //!< Maximum number of live areas.
+    unsigned m_min_log;  //!< Sizes are drawn log-uniformly in [2^min_log, 2^max_log).
+    unsigned m_max_log;
+    unsigned m_realloc;  //!< Percentage of operations on a live area that reallocate it.
+};
+
+const Workload workloads[] = {
+    {"small", 4u << 20, 512, 3, 8, 10},
+    {"mixed", 64u << 20, 1024, 3, 16, 25},
+};
+
+/// One pre-drawn operation: which slot to touch and, if it gets (re)allocated, how many bytes.
+struct Op
+{
+    uint32_t m_slot;
+    uint32_t m_bytes;
+    bool m_realloc;
+};
+
+std::vector<Op> draw(const Workload &w, size_t n_ops, uint32_t seed)
+{
+    std::mt19937 g(seed);
+    std::vector<Op> ops(n_ops);
+    for (auto &op : ops)
+    {
+        op.m_slot = g() % w.m_slots;
+        unsigned log = w.m_min_log + g() % (w.m_max_log - w.m_min_log);
+        op.m_bytes = (1u << log) + g() % (1u << log);
+        op.m_realloc = g() % 100 < w.m_realloc;
+    }
+
+    return ops;
+}
+
+/// A live area of the differential run.
+struct Area
+{
+    char *m_ptr = nullptr;
+    size_t m_bytes = 0u;
+    unsigned char m_fill = 0u;
+};
+
+bool intact(const Area &a)
+{
+    for (size_t i = 0; i < a.m_bytes; ++i)
+        if ((unsigned char)a.m_ptr[i] != a.m_fill)
+            return false;
+    return true;
+}
+
+/// Replays `ops` on the pool and on the model; returns a description of the first mismatch, or "".
+std::string differential(const Workload &w, const std::vector<Op> &ops)
+{
+    std::vector<Pool::Block> storage(w.m_pool_bytes / Pool::BLK_SZ);
+    char *base = reinterpret_cast<char *>(storage.data());
+    Pool pool(base, storage.size() * Pool::BLK_SZ);
+    Model model(storage.size());
+    std::vector<Area> slots(w.m_slots);
+    unsigned char fill = 0u;
+
+    auto blocks = [](size_t bytes) { return (bytes + Pool::HEADER_SZ + Pool::BLK_SZ - 1u) / Pool::BLK_SZ; };
+    auto offset = [base](const char *ptr) { return size_t(ptr - Pool::HEADER_SZ - base) / Pool::BLK_SZ; };
+
+    auto allocate = [&](size_t bytes, Area &area) -> std::string {
+        char *ptr = reinterpret_cast<char *>(pool.Allocate(bytes, std::nothrow));
+        long expected = model.Allocate(blocks(bytes));
+        if (expected < 0)
+            return ptr == nullptr ? "" : "allocation succeeded, the reference is full";
+        if (ptr == nullptr)
+            return "allocation failed, the reference found an area";
+        if (ptr != base + expected * Pool::BLK_SZ + Pool::HEADER_SZ)
+            return "allocation returned another area than the reference";
+        if (Pool::UsableSize(ptr) < bytes)
+            return "usable size below the requested size";
+
+        area.m_ptr = ptr;
+        area.m_bytes = bytes;
+        area.m_fill = ++fill;
+        std::memset(ptr, area.m_fill, bytes);
+        return "";
+    };
+
+    auto release = [&](Area &area) -> std::string {
+        if (not intact(area))
+            return "reserved area overwritten";
+        pool.Free(area.m_ptr);
+        model.Free(offset(area.m_ptr), blocks(area.m_bytes));
+        area = Area();
+        return "";
+    };
+
+    auto same_free_list = [&]() {
+        auto it = model.FreeAreas().begin(), end = model.FreeAreas().end();
+        bool same = true;
+        pool.ForEachFree([&](const void *a, size_t bytes) {
+            same = same and it != end and a == base + it->first * Pool::BLK_SZ and bytes == it->second * Pool::BLK_SZ;
+            if (it != end)
+                ++it;
+        });
+        return same and it == end;
+    };
+
+    std::string error;
+    for (size_t i = 0; i < ops.size() and error.empty(); ++i)
+    {
+        Area &area = slots[ops[i].m_slot];
+        if (area.m_ptr == nullptr)
+            error = allocate(ops[i].m_bytes, area);
+        else if (ops[i].m_realloc)
+        {
+            // Reallocate as a client would: new area, copy, free the old one.
+            Area moved;
+            error = allocate(ops[i].m_bytes, moved);
+            if (error.empty() and moved.m_ptr != nullptr)
+            {
+                if (not intact(area))
+                    error = "reserved area overwritten";
+                std::memcpy(moved.m_ptr, area.m_ptr, std::min(area.m_bytes, moved.m_bytes));
+                if (moved.m_bytes > area.m_bytes)
+                    std::memset(moved.m_ptr + area.m_bytes, area.m_fill, moved.m_bytes - area.m_bytes);
+                moved.m_fill = area.m_fill;
+                if (error.empty())
+                    error = release(area);
+                area = moved;
+            }
+        }
+        else
+            error = release(area);
+
+        if (error.empty() and i % 1024 == 0 and not same_free_list())
+            error = "free list differs from the reference";
+        if (not error.empty())
+            error += " (operation " + std::to_string(i) + ")";
+    }
+
+    for (auto &area : slots)
+        if (error.empty() and area.m_ptr != nullptr)
+            error = release(area);
+
+    if (error.empty() and not same_free_list())
+        error = "free list differs from the reference after freeing everything";
+    if (error.empty() and model.FreeAreas().size() != 1u)
+        error = "pool is not a single free area after freeing everything";
+
+    return error;
+}
+
+/// Replays `ops` on the pool alone; returns millions of operations per second.
+double throughput(const Workload &w, const std::vector<Op> &ops)
+{
+    Pool pool(w.m_pool_bytes);
+    std::vector<void *> slots(w.m_slots, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &op : ops)
+    {
+        void *&slot = slots[op.m_slot];
+        if (slot == nullptr)
+            slot = pool.Allocate(op.m_bytes, std::nothrow);
+        else if (op.m_realloc)
+        {
+            void *moved = pool.Allocate(op.m_bytes, std::nothrow);
+            if (moved != nullptr)
+            {
+                pool.Free(slot);
+                slot = moved;
+            }
+        }
+        else
+        {
+            pool.Free(slot);
+            slot = nullptr;
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (auto slot : slots)
+        if (slot != nullptr)
+            pool.Free(slot);
+
+    return ops.size() / elapsed.count();
+}
+
+/// Reads `workload threshold` pairs from the baseline file.
+std::map<std::string, double> read_baseline(const char *path)
+{
+    std::map<std::string, double> thresholds;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        double threshold;
+        if (line.empty() or line[0] == '#' or not(fields >> name >> threshold))
+            continue;
+        thresholds[name] = threshold;
+    }
+
+    return thresholds;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *baseline = argc > 1 ? argv[1] : nullptr;
+    size_t n_ops = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    auto failures(0);
+
+    std::cout << ">>> Begining STRESS tests (" << n_ops << " operations per workload)...\n\n";
+
+    for (auto &w : workloads)
+    {
+        std::string error = differential(w, draw(w, n_ops, 2018));
+
+        failures += not error.empty();
+        std::cout << ">>> Testing the " << w.m_name << " workload against the reference allocator... ";
+        std::cout << (error.empty() ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m " + error) << std::endl;
+    }
+
+    std::map<std::string, double> thresholds;
+    if (baseline != nullptr)
+    {
+        thresholds = read_baseline(baseline);
+        if (thresholds.empty())
+        {
+            std::cout << ">>> Could not read any threshold from " << baseline << std::endl;
+            ++failures;
+        }
+    }
+
+#ifdef NDEBUG
+    const bool gated = true;
+#else
+    const bool gated = false; // Unoptimised builds are not comparable with the baseline.
+#endif
+
+    for (auto &w : workloads)
+    {
+        double mops = throughput(w, draw(w, n_ops, 2019));
+        auto threshold = thresholds.find(w.m_name);
+        bool passed = not gated or threshold == thresholds.end() or mops >= threshold->second;
+
+        failures += not passed;
+        std::cout << ">>> Testing the " << w.m_name << " workload throughput (" << std::fixed << std::setprecision(2) << mops << " Mops/s";
+        if (threshold != thresholds.end())
+            std::cout << ", minimum " << threshold->second << (gated ? "" : ", not enforced");
+        std::cout << ")... " << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
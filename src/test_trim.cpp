@@ -0,0 +1,213 @@
+/**
+ * @file test_trim.cpp
+ *
+ * @description
+ * Test that free memory is given back to the OS without breaking the pool.
+ *
+ * 1) Trim() lowers the resident set after most of the pool has been freed.
+ * 2) Areas still reserved keep their data after a Trim().
+ * 3) A page is released (and counted) once: Trim() only visits what was freed since the last one.
+ * 4) Trimmed areas can be reserved and written again, and merge back into a single area.
+ * 5) PoolPurger trims an idle pool after the decay period.
+ * 6) PoolPurger leaves a pool alone while it keeps freeing, and counts each page once.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+#include "../include/mempool_common.h"
+#include "../include/SLPool.hpp"
+#include "../include/PoolPurger.hpp"
+
+using namespace mp;
+
+/// Resident set size of this process, in bytes.
+size_t resident()
+{
+    size_t pages(0), resident_pages(0);
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident_pages;
+    return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+int main()
+{
+    const short BLOCK_SIZE = 64;
+    using byte = char;
+    const size_t pool_size(32u << 20); // 32 MiB
+    const size_t chunk_len(64u << 10); // 64 KiB
+    const size_t n_chunks(pool_size / chunk_len - 1u);
+
+    auto failures(0);
+
+    std::cout << ">>> Begining TRIM tests...\n\n";
+
+    {
+        mp::SLPool<BLOCK_SIZE> p(pool_size);
+        byte *vet[n_chunks];
+
+        // Touch every page of the pool.
+        for (auto i(0u); i < n_chunks; ++i)
+        {
+            vet[i] = new (p) byte[chunk_len];
+            std::memset(vet[i], 'a' + i % 26, chunk_len);
+        }
+
+        // Keep one chunk out of eight.
+        for (auto i(0u); i < n_chunks; ++i)
+            if (i % 8 != 0)
+                delete[] vet[i];
+
+        size_t before(resident());
+        size_t released(p.Trim());
+        size_t after(resident());
+
+        // RSS may also grow meanwhile: compare rather than subtract.
+        bool passed = released > pool_size / 2 and after + pool_size / 2 < before and p.DirtyBytes() == 0u;
+        failures += not passed;
+        std::cout << ">>> Testing resident set after Trim() (" << (after < before ? before - after : 0u) / 1024 << " KiB released)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        passed = true;
+        for (auto i(0u); i < n_chunks and passed; i += 8)
+            for (auto j(0u); j < chunk_len and passed; ++j)
+                passed = vet[i][j] == byte('a' + i % 26);
+
+        failures += not passed;
+        std::cout << ">>> Testing reserved areas integrity after Trim()... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        // Nothing was freed since: nothing to release. Then only the chunk freed next.
+        size_t again(p.Trim());
+        delete[] vet[8];
+        size_t one(p.Trim());
+        // The chunk's first and last pages were shared with its neighbours, and kept until now.
+        passed = again == 0u and one > 0u and one <= chunk_len + 2 * sysconf(_SC_PAGESIZE);
+
+        failures += not passed;
+        std::cout << ">>> Testing pages are released once (" << one / 1024 << " KiB for a " << chunk_len / 1024 << " KiB chunk)... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+
+        vet[8] = new (p) byte[chunk_len];
+        std::memset(vet[8], 'a' + 8 % 26, chunk_len);
+
+        // Reuse the trimmed areas.
+        for (auto i(0u); i < n_chunks; ++i)
+            if (i % 8 != 0)
+            {
+                vet[i] = new (p) byte[chunk_len];
+                std::memset(vet[i], 'A' + i % 26, chunk_len);
+            }
+
+        passed = true;
+        for (auto i(0u); i < n_chunks and passed; ++i)
+            passed = vet[i][chunk_len - 1] == byte((i % 8 != 0 ? 'A' : 'a') + i % 26);
+
+        for (auto i(0u); i < n_chunks; ++i)
+            delete[] vet[i];
+
+        // Everything must have merged back into a single area.
+        try
+        {
+            delete[] new (p) byte[pool_size];
+        }
+        catch (std::bad_alloc &e)
+        {
+            passed = false;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing reuse of trimmed areas... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        mp::SLPool<BLOCK_SIZE> p(pool_size);
+        std::mutex lock;
+        mp::PoolPurger<mp::SLPool<BLOCK_SIZE>> purger(p, lock, std::chrono::milliseconds(40));
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            byte *area = new (p) byte[pool_size / 2];
+            std::memset(area, 'x', pool_size / 2);
+            delete[] area;
+        }
+
+        // Give the purger a few decay periods.
+        bool passed(false);
+        for (auto i(0); i < 50 and not passed; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            passed = purger.Released() >= pool_size / 4;
+        }
+
+        failures += not passed;
+        std::cout << ">>> Testing background purge after the decay period... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    {
+        const auto decay = std::chrono::milliseconds(40);
+        mp::SLPool<BLOCK_SIZE> p(pool_size);
+        std::mutex lock;
+        mp::PoolPurger<mp::SLPool<BLOCK_SIZE>> purger(p, lock, decay);
+
+        byte *spike;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            spike = new (p) byte[pool_size / 2];
+            std::memset(spike, 'x', pool_size / 2);
+            delete[] spike;
+        }
+
+        // Steady traffic for several decay periods: the purger must stay out of the way.
+        auto until = std::chrono::steady_clock::now() + 5 * decay;
+        while (std::chrono::steady_clock::now() < until)
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                byte *area = new (p) byte[chunk_len];
+                std::memset(area, 'y', chunk_len);
+                delete[] area;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        bool passed = purger.Released() == 0u;
+
+        // Once quiet, the spike goes back to the OS...
+        size_t first(0u);
+        for (auto i(0); i < 50 and first < pool_size / 4; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            first = purger.Released();
+        }
+
+        // ... and a later, small free only adds its own pages.
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            byte *area = new (p) byte[chunk_len];
+            std::memset(area, 'z', chunk_len);
+            delete[] area;
+        }
+        size_t second(first);
+        for (auto i(0); i < 50 and second == first; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            second = purger.Released();
+        }
+
+        passed = passed and first >= pool_size / 4 and second > first and second - first <= chunk_len + 2 * sysconf(_SC_PAGESIZE);
+
+        failures += not passed;
+        std::cout << ">>> Testing the purger waits for traffic to stop and counts pages once... ";
+        std::cout << (passed ? "\e[1;35mpassed!\e[0m" : "\e[1;31mfailed!\e[0m") << std::endl;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}